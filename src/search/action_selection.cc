@@ -8,6 +8,10 @@
 #include "utils/string_utils.h"
 #include "utils/system_utils.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
 /******************************************************************
                      Action Selection Creation
 ******************************************************************/
@@ -195,6 +199,36 @@ inline void ActionSelection::selectActionBasedOnVisitDifference(
                               UCB1
 ******************************************************************/
 
+void UCB1ActionSelection::calcUCB1Scores(double const* values,
+                                         double const* visits, double* scores,
+                                         size_t n, double const& magicConstant,
+                                         double const& parentVisitPart) {
+    for (size_t i = 0; i < n; ++i) {
+        scores[i] =
+            values[i] + magicConstant * std::sqrt(parentVisitPart / visits[i]);
+    }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("avx2"))) void UCB1ActionSelection::calcUCB1ScoresAVX2(
+    double const* values, double const* visits, double* scores, size_t n,
+    double const& magicConstant, double const& parentVisitPart) {
+    __m256d magicConstants = _mm256_set1_pd(magicConstant);
+    __m256d parentVisitParts = _mm256_set1_pd(parentVisitPart);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d visitParts = _mm256_mul_pd(
+            magicConstants,
+            _mm256_sqrt_pd(_mm256_div_pd(parentVisitParts,
+                                         _mm256_loadu_pd(visits + i))));
+        _mm256_storeu_pd(scores + i,
+                         _mm256_add_pd(_mm256_loadu_pd(values + i), visitParts));
+    }
+    calcUCB1Scores(values + i, visits + i, scores + i, n - i, magicConstant,
+                   parentVisitPart);
+}
+#endif
+
 void UCB1ActionSelection::_selectAction(SearchNode* node) {
     double magicConstant;
 
@@ -230,31 +264,55 @@ void UCB1ActionSelection::_selectAction(SearchNode* node) {
 
 
 
+    // Pack the statistics of the candidates
+    if (candidateIndices.size() < node->children.size()) {
+        candidateIndices.resize(node->children.size());
+        candidateValues.resize(node->children.size());
+        candidateVisits.resize(node->children.size());
+        candidateScores.resize(node->children.size());
+    }
+    size_t numberOfCandidates = 0;
     for (unsigned int childIndex = 0; childIndex < node->children.size();
          ++childIndex) {
-        if (node->children[childIndex] &&
-            node->children[childIndex]->initialized &&
-            !node->children[childIndex]->solved) {
-
-            double visitPart =
-                magicConstant *
-                std::sqrt(parentVisitPart /
-                          (double)node->children[childIndex]->numberOfVisits);
-
-            double UCTValue =
-                node->children[childIndex]->getExpectedAbstractRewardEstimate() +
-                visitPart;
-
-
-            assert(!MathUtils::doubleIsMinusInfinity(UCTValue));
+        SearchNode const* child = node->children[childIndex];
+        if (child && child->initialized && !child->solved) {
+            candidateIndices[numberOfCandidates] = childIndex;
+            candidateValues[numberOfCandidates] =
+                child->getExpectedAbstractRewardEstimate();
+            candidateVisits[numberOfCandidates] = child->numberOfVisits;
+            ++numberOfCandidates;
+        }
+    }
 
-            if (MathUtils::doubleIsGreater(UCTValue, bestUCTValue)) {
-                bestActionIndices.clear();
-                bestActionIndices.push_back(childIndex);
-                bestUCTValue = UCTValue;
-            } else if (MathUtils::doubleIsEqual(UCTValue, bestUCTValue)) {
-                bestActionIndices.push_back(childIndex);
-            }
+#if defined(__x86_64__) && defined(__GNUC__)
+    static bool const avx2Supported = __builtin_cpu_supports("avx2");
+    if (avx2Supported) {
+        calcUCB1ScoresAVX2(candidateValues.data(), candidateVisits.data(),
+                           candidateScores.data(), numberOfCandidates,
+                           magicConstant, parentVisitPart);
+    } else {
+        calcUCB1Scores(candidateValues.data(), candidateVisits.data(),
+                       candidateScores.data(), numberOfCandidates,
+                       magicConstant, parentVisitPart);
+    }
+#else
+    calcUCB1Scores(candidateValues.data(), candidateVisits.data(),
+                   candidateScores.data(), numberOfCandidates, magicConstant,
+                   parentVisitPart);
+#endif
+
+    // The best candidates are determined in order since ties are detected
+    // with a tolerance
+    for (size_t i = 0; i < numberOfCandidates; ++i) {
+        double UCTValue = candidateScores[i];
+        assert(!MathUtils::doubleIsMinusInfinity(UCTValue));
+
+        if (MathUtils::doubleIsGreater(UCTValue, bestUCTValue)) {
+            bestActionIndices.clear();
+            bestActionIndices.push_back(candidateIndices[i]);
+            bestUCTValue = UCTValue;
+        } else if (MathUtils::doubleIsEqual(UCTValue, bestUCTValue)) {
+            bestActionIndices.push_back(candidateIndices[i]);
         }
     }
 }
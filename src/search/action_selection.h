@@ -114,6 +114,33 @@ protected:
     // Parameter
     ExplorationRate explorationRate;
     double magicConstantScaleFactor;
+
+private:
+    // The indices, values and numbers of visits of the children that are
+    // candidates for selection are packed into these arrays, so the UCB1
+    // scores of all candidates can be computed in a single vectorized pass
+    std::vector<int> candidateIndices;
+    std::vector<double> candidateValues;
+    std::vector<double> candidateVisits;
+    std::vector<double> candidateScores;
+
+    // Computes scores[i] = values[i] + magicConstant * sqrt(parentVisitPart /
+    // visits[i]) for all i < n
+    static void calcUCB1Scores(double const* values, double const* visits,
+                               double* scores, size_t n,
+                               double const& magicConstant,
+                               double const& parentVisitPart);
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    // The same with AVX2 (division and square root are correctly rounded in
+    // both versions, so the scores are identical)
+    __attribute__((target("avx2"))) static void calcUCB1ScoresAVX2(
+        double const* values, double const* visits, double* scores, size_t n,
+        double const& magicConstant, double const& parentVisitPart);
+#endif
+
+    // Tests compare the scores of both versions
+    friend class UCB1ActionSelectionTest;
 };
 
 #endif
@@ -57,6 +57,22 @@ BackupFunction* BackupFunction::fromString(std::string& desc, THTS* thts) {
                          Backup Function
 ******************************************************************/
 
+VisitedChild::VisitedChild(SearchNode* _child, bool _isNew)
+    : child(_child),
+      oldEstimate(_child->getExpectedConcreteRewardEstimate()),
+      oldNumberOfVisits(_child->numberOfVisits),
+      wasSolved(_child->solved),
+      isNew(_isNew) {}
+
+bool BackupFunction::setValueFromString(std::string& param,
+                                        std::string& value) {
+    if (param == "-ib") {
+        setUseIncrementalBackups(atoi(value.c_str()));
+        return true;
+    }
+    return false;
+}
+
 void BackupFunction::backupDecisionNodeLeaf(SearchNode* node,
                                             double const& futReward) {
     ++node->numberOfVisits;
@@ -68,7 +84,8 @@ void BackupFunction::backupDecisionNodeLeaf(SearchNode* node,
     // std::cout << std::endl;
 }
 
-void BackupFunction::backupDecisionNode(SearchNode* node) {
+void BackupFunction::backupDecisionNode(SearchNode* node,
+                                        VisitedChild const& visited) {
     assert(!node->children.empty());
     assert(thts->getTipNodeOfTrial());
 
@@ -81,19 +98,19 @@ void BackupFunction::backupDecisionNode(SearchNode* node) {
 
     double oldFutureReward = node->futureReward;
 
-    // Propagate values from best child
-    node->futureReward = -std::numeric_limits<double>::max();
-    node->solved = useSolveLabeling;
-    for (SearchNode* child : node->children) {
-        if (child) {
-            if (child->initialized) {
-                node->solved &= child->solved;
-                node->futureReward = std::max(
-                    node->futureReward, child->getExpectedConcreteRewardEstimate());
-            } else {
-                node->solved = false;
-            }
-        }
+    // Propagate values from best child. With incremental backups, all
+    // children are only considered if the visited child has been solved or
+    // if it was the best child and its estimate decreased (children that are
+    // shared with transpositions might have changed via another parent, so
+    // these are always considered).
+    double estimate = visited.child->getExpectedConcreteRewardEstimate();
+    if (!useIncrementalBackups || thts->usesTranspositions() ||
+        (visited.child->solved && !visited.wasSolved)) {
+        rescanDecisionNode(node);
+    } else if (estimate >= node->futureReward) {
+        node->futureReward = estimate;
+    } else if (visited.oldEstimate >= node->futureReward) {
+        rescanDecisionNode(node);
     }
 
     // If the future reward did not change we did not find a better node and
@@ -111,10 +128,52 @@ void BackupFunction::backupDecisionNode(SearchNode* node) {
     // std::cout << std::endl;
 }
 
+void BackupFunction::rescanDecisionNode(SearchNode* node) {
+    if (useIncrementalBackups) {
+        ++numberOfRescans;
+    }
+
+    node->futureReward = -std::numeric_limits<double>::max();
+    node->solved = useSolveLabeling;
+    for (SearchNode* child : node->children) {
+        if (child) {
+            if (child->initialized) {
+                node->solved &= child->solved;
+                node->futureReward = std::max(
+                    node->futureReward, child->getExpectedConcreteRewardEstimate());
+            } else {
+                node->solved = false;
+            }
+        }
+    }
+}
+
+void BackupFunction::updateWeightedAverage(SearchNode* node,
+                                           VisitedChild const& visited,
+                                           double const& oldWeight,
+                                           double const& newWeight) {
+    double weightedSum = 0.0;
+    if (MathUtils::doubleIsGreater(node->childWeightSum, 0.0)) {
+        weightedSum = node->futureReward * node->childWeightSum;
+    }
+    if (!visited.isNew) {
+        weightedSum -= oldWeight * visited.oldEstimate;
+        node->childWeightSum -= oldWeight;
+    }
+    weightedSum +=
+        newWeight * visited.child->getExpectedConcreteRewardEstimate();
+    node->childWeightSum += newWeight;
+    node->futureReward = weightedSum / node->childWeightSum;
+}
+
 void BackupFunction::printStats(std::ostream& out, std::string indent) {
     if (useBackupLock) {
         out << indent << "Skipped backups: " << skippedBackups << std::endl;
     }
+    if (useIncrementalBackups) {
+        out << indent << "Rescanned decision nodes: " << numberOfRescans
+            << std::endl;
+    }
 }
 
 /******************************************************************
@@ -130,11 +189,12 @@ bool MCBackupFunction::setValueFromString(std::string& param,
         setLearningRateDecay(atof(value.c_str()));
         return true;
     }
-    return false;
+    return BackupFunction::setValueFromString(param, value);
 }
 
 void MCBackupFunction::backupChanceNode(SearchNode* node,
-                                        double const& futReward) {
+                                        double const& futReward,
+                                        VisitedChild const& /*visited*/) {
     ++node->numberOfVisits;
 
     node->futureReward =
@@ -164,10 +224,18 @@ void MCBackupFunction::backupChanceNode(SearchNode* node,
 ******************************************************************/
 
 void MaxMCBackupFunction::backupChanceNode(SearchNode* node,
-                                           double const& /*futReward*/) {
+                                           double const& /*futReward*/,
+                                           VisitedChild const& visited) {
     assert(MathUtils::doubleIsEqual(node->immediateReward, 0.0));
 
     ++node->numberOfVisits;
+    if (useIncrementalBackups) {
+        // The weight of a child is its number of visits
+        updateWeightedAverage(node, visited, visited.oldNumberOfVisits,
+                              visited.child->numberOfVisits);
+        return;
+    }
+
     node->futureReward = 0.0;
     int numberOfChildVisits = 0;
 
@@ -192,7 +260,8 @@ void MaxMCBackupFunction::backupChanceNode(SearchNode* node,
 ******************************************************************/
 
 void PBBackupFunction::backupChanceNode(SearchNode* node,
-                                        double const& /*futReward*/) {
+                                        double const& /*futReward*/,
+                                        VisitedChild const& visited) {
     assert(MathUtils::doubleIsEqual(node->immediateReward, 0.0));
 
     ++node->numberOfVisits;
@@ -201,6 +270,15 @@ void PBBackupFunction::backupChanceNode(SearchNode* node,
         return;
     }
 
+    if (useIncrementalBackups) {
+        // The weight of a child is its probability (and as below, chance
+        // nodes are not labeled as solved)
+        updateWeightedAverage(node, visited, visited.child->prob,
+                              visited.child->prob);
+        node->solved = false;
+        return;
+    }
+
     // Propagate values from children
     node->futureReward = 0.0;
     double solvedSum = 0.0;
@@ -6,6 +6,21 @@
 class THTS;
 class SearchNode;
 
+// The child of a node that has been visited in the current trial, together
+// with its estimate, number of visits and solvedness before it was visited.
+// This is what incremental backups need to update the node.
+struct VisitedChild {
+    VisitedChild(SearchNode* _child, bool _isNew);
+
+    SearchNode* child;
+    double oldEstimate;
+    int oldNumberOfVisits;
+    bool wasSolved;
+
+    // A new child has not been taken into account by the node yet
+    bool isNew;
+};
+
 /******************************************************************
                          Backup Function
 ******************************************************************/
@@ -18,9 +33,12 @@ public:
     static BackupFunction* fromString(std::string& desc, THTS* thts);
 
     // Set parameters from command line
-    virtual bool setValueFromString(std::string& /*param*/,
-                                    std::string& /*value*/) {
-        return false;
+    virtual bool setValueFromString(std::string& param, std::string& value);
+
+    // If incremental backups are used, a node is updated with the change of
+    // the visited child instead of considering all children
+    void setUseIncrementalBackups(bool _useIncrementalBackups) {
+        useIncrementalBackups = _useIncrementalBackups;
     }
 
     // Learns parameter values from a random training set
@@ -37,9 +55,10 @@ public:
     // Backup functions
     virtual void backupDecisionNodeLeaf(SearchNode* node,
                                         double const& futReward);
-    virtual void backupDecisionNode(SearchNode* node);
-    virtual void backupChanceNode(SearchNode* node,
-                                  double const& futReward) = 0;
+    virtual void backupDecisionNode(SearchNode* node,
+                                    VisitedChild const& visited);
+    virtual void backupChanceNode(SearchNode* node, double const& futReward,
+                                  VisitedChild const& visited) = 0;
 
     // Prints statistics
     virtual void printStats(std::ostream& out, std::string indent);
@@ -49,7 +68,19 @@ protected:
                    bool _useBackupLock = false)
         : thts(_thts),
           useSolveLabeling(_useSolveLabeling),
-          useBackupLock(_useBackupLock) {}
+          useBackupLock(_useBackupLock),
+          useIncrementalBackups(false),
+          numberOfRescans(0) {}
+
+    // Computes the value and solvedness of a decision node from all children
+    void rescanDecisionNode(SearchNode* node);
+
+    // Updates the weighted average of the children in futureReward if the
+    // weight and estimate of the visited child have changed from oldWeight
+    // and visited.oldEstimate to newWeight and its current estimate
+    void updateWeightedAverage(SearchNode* node, VisitedChild const& visited,
+                               double const& oldWeight,
+                               double const& newWeight);
 
     THTS* thts;
 
@@ -59,9 +90,11 @@ protected:
     // Parameter
     bool useSolveLabeling;
     bool useBackupLock;
+    bool useIncrementalBackups;
 
     // Statistics
     int skippedBackups;
+    int numberOfRescans;
 
     // Tests which access private members
     friend class BFSTestSearch;
@@ -91,7 +124,8 @@ public:
     }
 
     // Backup functions
-    void backupChanceNode(SearchNode* node, double const& futReward) override;
+    void backupChanceNode(SearchNode* node, double const& futReward,
+                          VisitedChild const& visited) override;
 
 private:
     double initialLearningRate;
@@ -107,7 +141,8 @@ public:
     MaxMCBackupFunction(THTS* _thts) : BackupFunction(_thts) {}
 
     // Backup functions
-    void backupChanceNode(SearchNode* node, double const& futReward) override;
+    void backupChanceNode(SearchNode* node, double const& futReward,
+                          VisitedChild const& visited) override;
 };
 
 /******************************************************************
@@ -119,7 +154,8 @@ public:
     PBBackupFunction(THTS* _thts) : BackupFunction(_thts, true, true) {}
 
     // Backup functions
-    void backupChanceNode(SearchNode* node, double const& futReward) override;
+    void backupChanceNode(SearchNode* node, double const& futReward,
+                          VisitedChild const& visited) override;
 };
 
 #endif
@@ -51,9 +51,10 @@ void DepthFirstSearch::applyAction(State const& state, int const& actionIndex,
     // cout << reward << endl;
 
     // Check if the next state is already cached
-    if (DeterministicSearchEngine::stateValueCache.find(nxt) !=
-        DeterministicSearchEngine::stateValueCache.end()) {
-        reward += DeterministicSearchEngine::stateValueCache[nxt];
+    StateValueHashMap::const_iterator it =
+        DeterministicSearchEngine::stateValueCache.find(nxt);
+    if (it != DeterministicSearchEngine::stateValueCache.end()) {
+        reward += it->second;
         return;
     }
 
@@ -93,3 +94,167 @@ void DepthFirstSearch::expandState(State const& state, double& result) {
         DeterministicSearchEngine::stateValueCache[state] = result;
     }
 }
+
+/******************************************************************
+                 Incremental Depth First Search
+******************************************************************/
+
+IncrementalDepthFirstSearch::IncrementalDepthFirstSearch()
+    : DepthFirstSearch(),
+      reusedTransitions(0),
+      reusedExpansions(0),
+      computedTransitions(0) {
+    name = "IncrementalDFS";
+}
+
+void IncrementalDepthFirstSearch::estimateQValue(State const& state,
+                                                 int actionIndex,
+                                                 double& qValue) {
+    assert(state.stepsToGo() > 0);
+    assert(state.stepsToGo() <= maxSearchDepth);
+
+    int rootIndex = prepareGraph(state);
+    int succIndex = applyAction(rootIndex, actionIndex, qValue);
+    qValue += calcValue(succIndex, state.stepsToGo() - 1);
+}
+
+void IncrementalDepthFirstSearch::estimateQValues(
+    State const& state, vector<int> const& actionsToExpand,
+    vector<double>& qValues) {
+    assert(state.stepsToGo() > 0);
+    assert(state.stepsToGo() <= maxSearchDepth);
+    assert(qValues.size() == SearchEngine::numberOfActions);
+
+    int rootIndex = prepareGraph(state);
+    for (unsigned int index = 0; index < qValues.size(); ++index) {
+        if (actionsToExpand[index] == index) {
+            int succIndex = applyAction(rootIndex, index, qValues[index]);
+            qValues[index] += calcValue(succIndex, state.stepsToGo() - 1);
+        }
+    }
+}
+
+int IncrementalDepthFirstSearch::prepareGraph(State const& root) {
+    // The graph of the previous call is only kept if the root state is the
+    // same (which is the case in consecutive iterations of IDS), as otherwise
+    // memory consumption would grow without limit
+    if (nodes.empty() || !State::EqualWithoutRemSteps()(nodes[0].state, root)) {
+        nodes.clear();
+        nodeIndices.clear();
+        getNodeIndex(root);
+    }
+    return 0;
+}
+
+int IncrementalDepthFirstSearch::getNodeIndex(State const& state) {
+    NodeHashMap::iterator it = nodeIndices.find(state);
+    if (it != nodeIndices.end()) {
+        return it->second;
+    }
+
+    int index = nodes.size();
+    nodes.push_back(Node(state));
+    nodes.back().state.stepsToGo() = 0;
+    nodes.back().successors.resize(SearchEngine::numberOfActions,
+                                   std::make_pair(-1, 0.0));
+    nodeIndices[state] = index;
+    return index;
+}
+
+int IncrementalDepthFirstSearch::applyAction(int nodeIndex,
+                                             int const& actionIndex,
+                                             double& reward) {
+    std::pair<int, double> const& succ =
+        nodes[nodeIndex].successors[actionIndex];
+    if (succ.first >= 0) {
+        ++reusedTransitions;
+        reward = succ.second;
+        return succ.first;
+    }
+
+    State nxt(0);
+    calcStateTransition(nodes[nodeIndex].state, actionIndex, nxt, reward);
+    int succIndex = getNodeIndex(nxt);
+
+    // getNodeIndex might have invalidated references into nodes
+    nodes[nodeIndex].successors[actionIndex] = std::make_pair(succIndex, reward);
+    ++computedTransitions;
+    return succIndex;
+}
+
+void IncrementalDepthFirstSearch::expandNode(int nodeIndex) {
+    assert(!nodes[nodeIndex].expanded);
+
+    vector<int> actionsToExpand = getApplicableActions(nodes[nodeIndex].state);
+    for (unsigned int index = 0; index < actionsToExpand.size(); ++index) {
+        if (actionsToExpand[index] == index) {
+            double reward = 0.0;
+            applyAction(nodeIndex, index, reward);
+        }
+    }
+    nodes[nodeIndex].expanded = true;
+}
+
+double IncrementalDepthFirstSearch::calcValue(int nodeIndex,
+                                              int const& stepsToGo) {
+    assert(stepsToGo > 0);
+
+    if ((nodes[nodeIndex].values.size() > stepsToGo) &&
+        !MathUtils::doubleIsMinusInfinity(
+            nodes[nodeIndex].values[stepsToGo])) {
+        return nodes[nodeIndex].values[stepsToGo];
+    }
+
+    // Use the same cache as DFS such that both can be used interchangeably
+    State& state = nodes[nodeIndex].state;
+    state.stepsToGo() = stepsToGo;
+    StateValueHashMap::iterator it =
+        DeterministicSearchEngine::stateValueCache.find(state);
+    state.stepsToGo() = 0;
+
+    double result = -numeric_limits<double>::max();
+    if (it != DeterministicSearchEngine::stateValueCache.end()) {
+        result = it->second;
+    } else if (stepsToGo == 1) {
+        calcOptimalFinalReward(state, result);
+    } else {
+        if (nodes[nodeIndex].expanded) {
+            ++reusedExpansions;
+        } else {
+            expandNode(nodeIndex);
+        }
+
+        for (size_t index = 0; index < nodes[nodeIndex].successors.size();
+             ++index) {
+            // Copy the successor as calcValue might invalidate references
+            std::pair<int, double> succ = nodes[nodeIndex].successors[index];
+            if (succ.first >= 0) {
+                result = std::max(
+                    result, succ.second + calcValue(succ.first, stepsToGo - 1));
+            }
+        }
+
+        if (cachingEnabled) {
+            State cachedState(nodes[nodeIndex].state);
+            cachedState.stepsToGo() = stepsToGo;
+            DeterministicSearchEngine::stateValueCache[cachedState] = result;
+        }
+    }
+
+    if (nodes[nodeIndex].values.size() <= stepsToGo) {
+        nodes[nodeIndex].values.resize(stepsToGo + 1,
+                                       -numeric_limits<double>::max());
+    }
+    nodes[nodeIndex].values[stepsToGo] = result;
+    return result;
+}
+
+void IncrementalDepthFirstSearch::printStats(ostream& out,
+                                             bool const& printRoundStats,
+                                             string indent) const {
+    SearchEngine::printStats(out, printRoundStats, indent);
+    out << indent << "Computed transitions: " << computedTransitions << endl;
+    out << indent << "Reused transitions: " << reusedTransitions << endl;
+    out << indent << "Reused expansions: " << reusedExpansions << endl;
+    out << indent << "Nodes in last graph: " << nodes.size() << endl;
+}
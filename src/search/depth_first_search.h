@@ -8,6 +8,7 @@
 
 #include <cassert>
 #include <set>
+#include <unordered_map>
 
 class ProstPlanner;
 class UCTSearchEngine;
@@ -39,4 +40,78 @@ private:
     double rewardHelperVar;
 };
 
+// Depth first search that keeps the explicated part of the determinized search
+// space between consecutive calls with the same root state. This is meant to be
+// used by IDS: each iteration with an increased search depth only has to
+// evaluate CPFs for the newly reached frontier, while transitions and rewards
+// of the previous iterations are looked up in the stored graph. State values
+// are stored for each number of remaining steps, so this also serves as a
+// depth-indexed transposition table.
+class IncrementalDepthFirstSearch : public DepthFirstSearch {
+public:
+    IncrementalDepthFirstSearch();
+
+    // Start the search engine to estimate the Q-value of a single action
+    void estimateQValue(State const& state, int actionIndex,
+                        double& qValue) override;
+
+    // Start the search engine to estimate the Q-values of all applicable
+    // actions
+    void estimateQValues(State const& state,
+                         std::vector<int> const& actionsToExpand,
+                         std::vector<double>& qValues) override;
+
+    // Print
+    void printStats(std::ostream& out, bool const& printRoundStats,
+                    std::string indent = "") const override;
+
+private:
+    struct Node {
+        Node(State const& _state) : state(_state), expanded(false) {}
+
+        // The stored state (its number of remaining steps is always 0 as the
+        // same node is used for all remaining steps)
+        State state;
+
+        // Successor node index and reward of each reasonable action (the
+        // successors are only known if the node has been expanded)
+        std::vector<std::pair<int, double>> successors;
+        bool expanded;
+
+        // values[k] is the value of this node with k remaining steps (or minus
+        // infinity if it has not been computed yet)
+        std::vector<double> values;
+    };
+
+    typedef std::unordered_map<State, int, State::HashWithoutRemSteps,
+                               State::EqualWithoutRemSteps>
+        NodeHashMap;
+
+    // Makes sure that the stored graph belongs to the given root state and
+    // returns the index of the root node
+    int prepareGraph(State const& root);
+
+    // Returns the index of the node that represents state (which is created if
+    // it does not exist yet)
+    int getNodeIndex(State const& state);
+
+    // Returns the index of the successor of node when actionIndex is applied
+    // and stores the obtained reward in reward
+    int applyAction(int nodeIndex, int const& actionIndex, double& reward);
+
+    // Calculates the value of node with stepsToGo remaining steps
+    double calcValue(int nodeIndex, int const& stepsToGo);
+
+    // Generates the successors of all reasonable actions of node
+    void expandNode(int nodeIndex);
+
+    std::vector<Node> nodes;
+    NodeHashMap nodeIndices;
+
+    // Statistics
+    int reusedTransitions;
+    int reusedExpansions;
+    int computedTransitions;
+};
+
 #endif
@@ -25,42 +25,31 @@ public:
         case NONE:
             formula->evaluateToKleene(res, current, actions);
             break;
-        case MAP:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
-
-            if (kleeneEvaluationCacheMap.find(stateHashKey) !=
-                kleeneEvaluationCacheMap.end()) {
-                res = kleeneEvaluationCacheMap[stateHashKey];
+        case MAP: {
+            long stateHashKey = getStateHashKey(current, actions);
+            std::unordered_map<long, std::set<double>>::const_iterator it =
+                kleeneEvaluationCacheMap.find(stateHashKey);
+            if (it != kleeneEvaluationCacheMap.end()) {
+                res = it->second;
             } else {
                 formula->evaluateToKleene(res, current, actions);
                 kleeneEvaluationCacheMap[stateHashKey] = res;
             }
             break;
-        case DISABLED_MAP:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
-
-            if (kleeneEvaluationCacheMap.find(stateHashKey) !=
-                kleeneEvaluationCacheMap.end()) {
-                res = kleeneEvaluationCacheMap[stateHashKey];
+        }
+        case DISABLED_MAP: {
+            std::unordered_map<long, std::set<double>>::const_iterator it =
+                kleeneEvaluationCacheMap.find(
+                    getStateHashKey(current, actions));
+            if (it != kleeneEvaluationCacheMap.end()) {
+                res = it->second;
             } else {
                 formula->evaluateToKleene(res, current, actions);
             }
-
             break;
-        case VECTOR:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
+        }
+        case VECTOR: {
+            long stateHashKey = getStateHashKey(current, actions);
             assert(stateHashKey < kleeneEvaluationCacheVector.size());
 
             if (kleeneEvaluationCacheVector[stateHashKey].empty()) {
@@ -71,6 +60,7 @@ public:
             }
             break;
         }
+        }
     }
 
     // Properties
@@ -110,12 +100,20 @@ public:
     // state)
     std::vector<long> actionHashKeyMap;
 
-    // This is a temporary variable used in evaluate. It is a member var as
-    // initializing variables in case statements is only possible if additional
-    // parentheses are used
-    long stateHashKey;
-
 protected:
+    // Returns the key of the cache entry of current and actions. The key is
+    // not stored in a member, so cached values can be read concurrently (see
+    // IDS::learn).
+    template <typename StateType>
+    long getStateHashKey(StateType const& current,
+                         ActionState const& actions) const {
+        long stateHashKey = current.stateFluentHashKey(hashIndex) +
+                            actionHashKeyMap[actions.index];
+        assert((current.stateFluentHashKey(hashIndex) >= 0) &&
+               (actionHashKeyMap[actions.index] >= 0) && (stateHashKey >= 0));
+        return stateHashKey;
+    }
+
     Evaluatable(std::string _name, int _hashIndex)
         : name(_name),
           formula(nullptr),
@@ -147,43 +145,30 @@ public:
         case NONE:
             formula->evaluate(res, current, actions);
             break;
-        case MAP:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
-
-            if (evaluationCacheMap.find(stateHashKey) !=
-                evaluationCacheMap.end()) {
-                res = evaluationCacheMap[stateHashKey];
+        case MAP: {
+            long stateHashKey = getStateHashKey(current, actions);
+            std::unordered_map<long, double>::const_iterator it =
+                evaluationCacheMap.find(stateHashKey);
+            if (it != evaluationCacheMap.end()) {
+                res = it->second;
             } else {
                 formula->evaluate(res, current, actions);
                 evaluationCacheMap[stateHashKey] = res;
             }
             break;
-        case DISABLED_MAP:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
-
-            if (evaluationCacheMap.find(stateHashKey) !=
-                evaluationCacheMap.end()) {
-                res = evaluationCacheMap[stateHashKey];
+        }
+        case DISABLED_MAP: {
+            std::unordered_map<long, double>::const_iterator it =
+                evaluationCacheMap.find(getStateHashKey(current, actions));
+            if (it != evaluationCacheMap.end()) {
+                res = it->second;
             } else {
                 formula->evaluate(res, current, actions);
             }
-
             break;
-        case VECTOR:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
+        }
+        case VECTOR: {
+            long stateHashKey = getStateHashKey(current, actions);
             assert(stateHashKey < evaluationCacheVector.size());
             assert(!MathUtils::doubleIsMinusInfinity(
                 evaluationCacheVector[stateHashKey]));
@@ -191,6 +176,7 @@ public:
             res = evaluationCacheVector[stateHashKey];
             break;
         }
+        }
     }
 
     bool isProbabilistic() const {
@@ -215,48 +201,37 @@ public:
         case NONE:
             formula->evaluateToPD(res, current, actions);
             break;
-        case MAP:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
-
-            if (evaluationCacheMap.find(stateHashKey) !=
-                evaluationCacheMap.end()) {
-                res = evaluationCacheMap[stateHashKey];
+        case MAP: {
+            long stateHashKey = getStateHashKey(current, actions);
+            std::unordered_map<long, DiscretePD>::const_iterator it =
+                evaluationCacheMap.find(stateHashKey);
+            if (it != evaluationCacheMap.end()) {
+                res = it->second;
             } else {
                 formula->evaluateToPD(res, current, actions);
                 evaluationCacheMap[stateHashKey] = res;
             }
             break;
-        case DISABLED_MAP:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
-
-            if (evaluationCacheMap.find(stateHashKey) !=
-                evaluationCacheMap.end()) {
-                res = evaluationCacheMap[stateHashKey];
+        }
+        case DISABLED_MAP: {
+            std::unordered_map<long, DiscretePD>::const_iterator it =
+                evaluationCacheMap.find(getStateHashKey(current, actions));
+            if (it != evaluationCacheMap.end()) {
+                res = it->second;
             } else {
                 formula->evaluateToPD(res, current, actions);
             }
             break;
-        case VECTOR:
-            stateHashKey = current.stateFluentHashKey(hashIndex) +
-                           actionHashKeyMap[actions.index];
-
-            assert((current.stateFluentHashKey(hashIndex) >= 0) &&
-                   (actionHashKeyMap[actions.index] >= 0) &&
-                   (stateHashKey >= 0));
+        }
+        case VECTOR: {
+            long stateHashKey = getStateHashKey(current, actions);
             assert(stateHashKey < evaluationCacheVector.size());
             assert(!evaluationCacheVector[stateHashKey].isUndefined());
 
             res = evaluationCacheVector[stateHashKey];
             break;
         }
+        }
     }
 
     bool isProbabilistic() const {
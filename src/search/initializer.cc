@@ -71,6 +71,10 @@ void Initializer::disableCaching() {
     heuristic->disableCaching();
 }
 
+void Initializer::finishStep() {
+    heuristic->finishStep();
+}
+
 void Initializer::learn() {
     heuristic->learn();
 
@@ -82,6 +86,30 @@ void Initializer::learn() {
     }
 }
 
+void Initializer::writeLearnedParameters(std::ostream& out) const {
+    // We store if learning replaced the heuristic with uniform evaluation
+    char heuristicReplaced =
+        (dynamic_cast<UniformEvaluationSearch*>(heuristic) != nullptr);
+    out.write(&heuristicReplaced, sizeof(heuristicReplaced));
+    heuristic->writeLearnedParameters(out);
+}
+
+bool Initializer::readLearnedParameters(std::istream& in) {
+    char heuristicReplaced = 0;
+    if (!in.read(&heuristicReplaced, sizeof(heuristicReplaced))) {
+        return false;
+    }
+    if (!heuristicReplaced) {
+        return heuristic->readLearnedParameters(in);
+    }
+    if (!dynamic_cast<UniformEvaluationSearch*>(heuristic)) {
+        setHeuristic(new UniformEvaluationSearch());
+        std::cout << "Search depth is too low for selected heuristic!"
+                  << std::endl;
+    }
+    return true;
+}
+
 /******************************************************************
                           Parameter Setter
 ******************************************************************/
@@ -22,9 +22,16 @@ public:
     // Learns parameter values from a random training set
     virtual void learn();
 
+    // Write and restore the parameters determined in learn()
+    virtual void writeLearnedParameters(std::ostream& out) const;
+    virtual bool readLearnedParameters(std::istream& in);
+
     // This is called when caching is disabled because memory becomes sparse
     virtual void disableCaching();
 
+    // This is called after each step and is passed on to the heuristic
+    virtual void finishStep();
+
     virtual void initRound() {}
     virtual void initTrial() {}
 
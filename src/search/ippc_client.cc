@@ -239,6 +239,10 @@ bool IPPCClient::submitAction(vector<string>& actions,
     if (write(socket, os.str().c_str(), os.str().length()) == -1) {
         return false;
     }
+
+    // Use the time until the server responds for the next step
+    while (!XMLNode::hasInput(socket) && planner->ponder()) {
+    }
     XMLNode const* serverResponse = XMLNode::readNode(socket);
 
     bool roundContinues = true;
@@ -267,8 +271,6 @@ void IPPCClient::readState(XMLNode const* node, vector<double>& nextState,
         assert(false);
     }
 
-    map<string, string> newValues;
-
     string s;
     if (!node->dissect("time-left", s)) {
         SystemUtils::abort("Error: turn response message insufficient.");
@@ -280,91 +282,79 @@ void IPPCClient::readState(XMLNode const* node, vector<double>& nextState,
     }
     immediateReward = atof(s.c_str());
 
+    // The name and value are reused for all fluents
+    string varName;
+    string value;
     for (int i = 0; i < node->size(); i++) {
         XMLNode const* child = node->getChild(i);
-        if (child->getName() == "observed-fluent") {
-            readVariable(child, newValues);
+        if (child->getName() != "observed-fluent") {
+            continue;
         }
-    }
+        readVariable(child, varName, value);
 
-    for (map<string, string>::iterator it = newValues.begin();
-         it != newValues.end(); ++it) {
-        string varName = it->first;
-        string value = it->second;
-
-        // If the variable has no parameters, its name is different from the one
-        // that is used by PROST internally where no parents are used (afaik,
-        // this changed at some point in rddlsim, and I am not sure if it will
-        // change back which is why this hacky solution is fine for the moment).
-        if (varName[varName.length() - 2] == '(') {
-            varName = varName.substr(0, varName.length() - 2);
+        map<string, int>::const_iterator it =
+            stateVariableIndices.find(varName);
+        if (it == stateVariableIndices.end()) {
+            continue;
         }
-
-        if (stateVariableIndices.find(varName) != stateVariableIndices.end()) {
-            if (stateVariableValues[stateVariableIndices[varName]].empty()) {
-                // TODO: This should be a numerical variable without
-                // value->index mapping, but it can also be a boolean one atm.
-                if (value == "true") {
-                    nextState[stateVariableIndices[varName]] = 1.0;
-                } else if (value == "false") {
-                    nextState[stateVariableIndices[varName]] = 0.0;
-                } else {
-                    nextState[stateVariableIndices[varName]] =
-                        atof(value.c_str());
-                }
+        int index = it->second;
+        vector<string> const& values = stateVariableValues[index];
+        if (values.empty()) {
+            // TODO: This should be a numerical variable without value->index
+            // mapping, but it can also be a boolean one atm.
+            if (value == "true") {
+                nextState[index] = 1.0;
+            } else if (value == "false") {
+                nextState[index] = 0.0;
             } else {
-                for (unsigned int i = 0;
-                     i <
-                     stateVariableValues[stateVariableIndices[varName]].size();
-                     ++i) {
-                    if (stateVariableValues[stateVariableIndices[varName]][i] ==
-                        value) {
-                        nextState[stateVariableIndices[varName]] = i;
-                        break;
-                    }
+                nextState[index] = atof(value.c_str());
+            }
+        } else {
+            for (unsigned int j = 0; j < values.size(); ++j) {
+                if (values[j] == value) {
+                    nextState[index] = j;
+                    break;
                 }
             }
         }
     }
 }
 
-void IPPCClient::readVariable(XMLNode const* node,
-                              map<string, string>& result) {
-    string name;
-    if (node->getName() != "observed-fluent") {
-        assert(false);
-    }
-
+void IPPCClient::readVariable(XMLNode const* node, string& name,
+                              string& value) {
     if (!node->dissect("fluent-name", name)) {
         assert(false);
     }
-    name = name.substr(0, name.length() - 1);
-
-    vector<string> params;
-    string value;
-    string fluentName;
+    // The texts end with a delimiter that is removed (if a malformed message
+    // contains an empty text, there is nothing to remove)
+    if (!name.empty()) {
+        name.pop_back();
+    }
 
+    // If the variable has no parameters, its name is different from the one
+    // that is used by PROST internally where no parents are used (afaik, this
+    // changed at some point in rddlsim, and I am not sure if it will change
+    // back which is why this hacky solution is fine for the moment).
+    bool hasParams = false;
+    value.clear();
     for (int i = 0; i < node->size(); i++) {
         XMLNode const* paramNode = node->getChild(i);
         if (!paramNode) {
             assert(false);
             continue;
         } else if (paramNode->getName() == "fluent-arg") {
-            string param = paramNode->getText();
-            params.push_back(param.substr(0, param.length() - 1));
+            string const param = paramNode->getText();
+            name += hasParams ? ", " : "(";
+            name.append(param, 0, param.length() - 1);
+            hasParams = true;
         } else if (paramNode->getName() == "fluent-value") {
             value = paramNode->getText();
-            value = value.substr(0, value.length() - 1);
+            if (!value.empty()) {
+                value.pop_back();
+            }
         }
     }
-    name += "(";
-    for (unsigned int i = 0; i < params.size(); ++i) {
-        name += params[i];
-        if (i != params.size() - 1) {
-            name += ", ";
-        }
+    if (hasParams) {
+        name += ")";
     }
-    name += ")";
-    assert(result.find(name) == result.end());
-    result[name] = value;
 }
@@ -41,8 +41,8 @@ private:
 
     void readState(XMLNode const* node, std::vector<double>& nextState,
                    double& immediateReward);
-    void readVariable(XMLNode const* node,
-                      std::map<std::string, std::string>& result);
+    void readVariable(XMLNode const* node, std::string& name,
+                      std::string& value);
 
     ProstPlanner* planner;
     std::string hostName;
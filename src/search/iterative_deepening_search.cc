@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <iostream>
 #include <numeric>
+#include <thread>
 
 using namespace std;
 
@@ -22,13 +23,19 @@ IDS::IDS()
     : DeterministicSearchEngine("IDS"),
       isLearning(false),
       stopwatch(),
+      learningStopwatch(),
       maxSearchDepthForThisStep(0),
       ramLimitReached(false),
       strictTerminationTimeout(0.1),
       terminateWithReasonableAction(true),
+      useIncrementalSearch(false),
+      adaptSearchDepth(true),
+      numberOfLearningThreads(0),
       accumulatedSearchDepth(0),
       cacheHits(0),
-      numberOfRuns(0) {
+      numberOfRuns(0),
+      searchDepthIncreases(0),
+      searchDepthDecreases(0) {
     setTimeout(0.005);
 
     if (rewardCache.bucket_count() < 520241) {
@@ -36,11 +43,16 @@ IDS::IDS()
     }
 
     elapsedTime.resize(maxSearchDepth + 1);
+    searchDepthLimit = maxSearchDepth;
 
     dfs = new DepthFirstSearch();
     dfs->setMaxSearchDepth(maxSearchDepth);
 }
 
+IDS::~IDS() {
+    delete dfs;
+}
+
 bool IDS::setValueFromString(string& param, string& value) {
     if (param == "-st") {
         setStrictTerminationTimeout(atof(value.c_str()));
@@ -48,6 +60,15 @@ bool IDS::setValueFromString(string& param, string& value) {
     } else if (param == "-tra") {
         setTerminateWithReasonableAction(atoi(value.c_str()));
         return true;
+    } else if (param == "-inc") {
+        setUseIncrementalSearch(atoi(value.c_str()));
+        return true;
+    } else if (param == "-ad") {
+        setAdaptSearchDepth(atoi(value.c_str()));
+        return true;
+    } else if (param == "-lt") {
+        setNumberOfLearningThreads(atoi(value.c_str()));
+        return true;
     }
 
     return SearchEngine::setValueFromString(param, value);
@@ -68,6 +89,22 @@ void IDS::setCachingEnabled(bool newValue) {
     dfs->setCachingEnabled(newValue);
 }
 
+void IDS::setUseIncrementalSearch(bool newValue) {
+    if (newValue == useIncrementalSearch) {
+        return;
+    }
+    useIncrementalSearch = newValue;
+
+    delete dfs;
+    if (useIncrementalSearch) {
+        dfs = new IncrementalDepthFirstSearch();
+    } else {
+        dfs = new DepthFirstSearch();
+    }
+    dfs->setMaxSearchDepth(maxSearchDepth);
+    dfs->setCachingEnabled(cachingEnabled);
+}
+
 /******************************************************************
                  Search Engine Administration
 ******************************************************************/
@@ -78,24 +115,92 @@ void IDS::disableCaching() {
     ramLimitReached = true;
 }
 
+// Switches all evaluatables that cache with a map to the read-only
+// DISABLED_MAP and returns those that have been switched
+static vector<Evaluatable*> makeCachesReadOnly(
+    vector<Evaluatable*> const& evaluatables) {
+    vector<Evaluatable*> res;
+    for (Evaluatable* eval : evaluatables) {
+        if (eval->cachingType == Evaluatable::MAP) {
+            eval->cachingType = Evaluatable::DISABLED_MAP;
+            res.push_back(eval);
+        }
+    }
+    return res;
+}
+
 void IDS::learn() {
     dfs->learn();
     cout << name << ": learning..." << endl;
 
-    isLearning = true;
-    bool cachingEnabledBeforeLearning = cachingIsEnabled();
-    cachingEnabled = false;
+    searchDepthLimit = maxSearchDepth;
+
+    // The training set is split among several workers that run in parallel.
+    // Each worker is an IDS instance of its own, and all caches that are
+    // shared between search engines are read-only while learning.
+    size_t numberOfWorkers = numberOfLearningThreads;
+    if (numberOfWorkers == 0) {
+        numberOfWorkers = std::thread::hardware_concurrency();
+    }
+    numberOfWorkers =
+        std::max<size_t>(std::min(numberOfWorkers, trainingSet.size()), 1);
+
+    vector<IDS*> workers(numberOfWorkers);
+    for (size_t i = 0; i < numberOfWorkers; ++i) {
+        workers[i] = new IDS();
+        workers[i]->setUseIncrementalSearch(useIncrementalSearch);
+        workers[i]->setStrictTerminationTimeout(strictTerminationTimeout);
+        workers[i]->setCachingEnabled(false);
+        workers[i]->setMaxSearchDepth(maxSearchDepth);
+        workers[i]->isLearning = true;
+    }
+
+    vector<Evaluatable*> evaluatables(deterministicCPFs.begin(),
+                                      deterministicCPFs.end());
+    evaluatables.insert(evaluatables.end(), determinizedCPFs.begin(),
+                        determinizedCPFs.end());
+    evaluatables.insert(evaluatables.end(), actionPreconditions.begin(),
+                        actionPreconditions.end());
+    evaluatables.push_back(rewardCPF);
+    vector<Evaluatable*> readOnlyEvaluatables =
+        makeCachesReadOnly(evaluatables);
+    bool cacheApplicableActionsBeforeLearning = cacheApplicableActions;
+    cacheApplicableActions = false;
 
     // Perform IDS for all states in trainingSet and record the time it takes
-    for (size_t i = 0; i < trainingSet.size(); ++i) {
-        State copy(trainingSet[i]);
-        vector<double> res(numberOfActions);
-        vector<int> actionsToExpand = getApplicableActions(copy);
-        estimateQValues(copy, actionsToExpand, res);
+    // (the first worker runs in this thread)
+    vector<std::thread> threads;
+    for (size_t i = 1; i < numberOfWorkers; ++i) {
+        threads.emplace_back(&IDS::learnOnTrainingSet, workers[i], i,
+                             numberOfWorkers);
+    }
+    workers[0]->learnOnTrainingSet(0, numberOfWorkers);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    cacheApplicableActions = cacheApplicableActionsBeforeLearning;
+    for (Evaluatable* eval : readOnlyEvaluatables) {
+        eval->cachingType = Evaluatable::MAP;
     }
 
-    isLearning = false;
-    cachingEnabled = cachingEnabledBeforeLearning;
+    // Merge the results of the workers. If a worker violated the strict
+    // timeout, it has decreased its maximal search depth and discarded the
+    // times of all higher search depths, so we do the same for all workers.
+    for (IDS* worker : workers) {
+        maxSearchDepth = std::min(maxSearchDepth, worker->maxSearchDepth);
+        if (worker->elapsedTime.size() < elapsedTime.size()) {
+            elapsedTime.resize(worker->elapsedTime.size());
+        }
+    }
+    for (IDS* worker : workers) {
+        for (size_t index = 0; index < elapsedTime.size(); ++index) {
+            elapsedTime[index].insert(elapsedTime[index].end(),
+                                      worker->elapsedTime[index].begin(),
+                                      worker->elapsedTime[index].end());
+        }
+        delete worker;
+    }
     assert(rewardCache.empty());
 
     if (maxSearchDepth > 1) {
@@ -128,6 +233,104 @@ void IDS::learn() {
     cout << name << ": ...finished" << endl;
 }
 
+void IDS::learnOnTrainingSet(size_t firstIndex, size_t increment) {
+    for (size_t i = firstIndex; i < trainingSet.size(); i += increment) {
+        State copy(trainingSet[i]);
+        vector<double> res(numberOfActions);
+        vector<int> actionsToExpand = getApplicableActions(copy);
+        estimateQValues(copy, actionsToExpand, res);
+    }
+}
+
+void IDS::writeLearnedParameters(ostream& out) const {
+    out.write(reinterpret_cast<char const*>(&maxSearchDepth),
+              sizeof(maxSearchDepth));
+}
+
+bool IDS::readLearnedParameters(istream& in) {
+    int learnedMaxSearchDepth = 0;
+    if (!in.read(reinterpret_cast<char*>(&learnedMaxSearchDepth),
+                 sizeof(learnedMaxSearchDepth)) ||
+        (learnedMaxSearchDepth < 0) ||
+        (learnedMaxSearchDepth > maxSearchDepth)) {
+        return false;
+    }
+    dfs->learn();
+    searchDepthLimit = maxSearchDepth;
+    setMaxSearchDepth(learnedMaxSearchDepth);
+    cout << name << ": Setting max search depth to " << maxSearchDepth
+         << " (as learned in a previous run)!" << endl;
+    return true;
+}
+
+void IDS::finishStep() {
+    if (!adaptSearchDepth || (maxSearchDepth < 2)) {
+        stepTime.clear();
+        return;
+    }
+
+    // If the iterations on the current maximal search depth took longer than
+    // the timeout on average, we decrease the maximal search depth
+    int newMaxSearchDepth = maxSearchDepth;
+    while (newMaxSearchDepth > 2) {
+        double avgTime = getAverageStepTime(newMaxSearchDepth);
+        if ((avgTime < 0.0) ||
+            !MathUtils::doubleIsGreater(avgTime, timeout)) {
+            break;
+        }
+        --newMaxSearchDepth;
+    }
+
+    // Otherwise, we estimate the time of the next iteration by assuming that
+    // the growth from the previous to the current search depth continues, and
+    // increase the maximal search depth if the estimate is below the timeout.
+    // As IDS is expensive without caching, we never increase the maximal
+    // search depth once the RAM limit has been reached.
+    if ((newMaxSearchDepth == maxSearchDepth) && !ramLimitReached &&
+        (maxSearchDepth < searchDepthLimit)) {
+        double avgTime = getAverageStepTime(maxSearchDepth);
+        double prevAvgTime = getAverageStepTime(maxSearchDepth - 1);
+        if ((avgTime >= 0.0) && MathUtils::doubleIsGreater(prevAvgTime, 0.0)) {
+            double estimatedTime = avgTime * (avgTime / prevAvgTime);
+            if (MathUtils::doubleIsSmaller(estimatedTime, timeout)) {
+                ++newMaxSearchDepth;
+            }
+        }
+    }
+
+    if (newMaxSearchDepth > maxSearchDepth) {
+        ++searchDepthIncreases;
+    } else if (newMaxSearchDepth < maxSearchDepth) {
+        ++searchDepthDecreases;
+    }
+    if (newMaxSearchDepth != maxSearchDepth) {
+        cout << name << ": Setting max search depth to " << newMaxSearchDepth
+             << "!" << endl;
+        setMaxSearchDepth(newMaxSearchDepth);
+    }
+    stepTime.clear();
+}
+
+void IDS::recordStepTime(int const& stepsToGo, double const& time) {
+    if (stepTime.size() <= stepsToGo) {
+        stepTime.resize(stepsToGo + 1);
+    }
+    stepTime[stepsToGo].push_back(time);
+}
+
+double IDS::getAverageStepTime(int const& stepsToGo) const {
+    // We require a minimal number of samples to avoid that a few outliers
+    // change the maximal search depth
+    static size_t const minNumberOfSamples = 10;
+    if ((stepTime.size() <= stepsToGo) ||
+        (stepTime[stepsToGo].size() < minNumberOfSamples)) {
+        return -1.0;
+    }
+    vector<double> const& times = stepTime[stepsToGo];
+    double timeSum = std::accumulate(times.begin(), times.end(), 0.0);
+    return timeSum / static_cast<double>(times.size());
+}
+
 /******************************************************************
                        Main Search Functions
 ******************************************************************/
@@ -188,6 +391,9 @@ void IDS::estimateQValues(State const& state,
         }
     } else {
         stopwatch.reset();
+        if (isLearning) {
+            learningStopwatch.reset();
+        }
 
         maxSearchDepthForThisStep = std::min(maxSearchDepth, state.stepsToGo());
 
@@ -228,6 +434,7 @@ void IDS::estimateQValues(State const& state,
 
 bool IDS::moreIterations(int const& stepsToGo) {
     double time = stopwatch();
+    recordStepTime(stepsToGo, time);
 
     // 1. If caching was disabled, we check if the strict timeout is violated to
     // readjust the maximal search depth
@@ -253,10 +460,9 @@ bool IDS::moreIterations(int const& stepsToGo) {
 bool IDS::moreIterations(int const& stepsToGo,
                          vector<int> const& actionsToExpand,
                          vector<double>& qValues) {
-    double time = stopwatch();
-
     // 0. If we are learning, we apply different termination criteria
     if (isLearning) {
+        double time = learningStopwatch();
         assert(elapsedTime.size() > stepsToGo);
         elapsedTime[stepsToGo].push_back(time);
 
@@ -270,6 +476,9 @@ bool IDS::moreIterations(int const& stepsToGo,
         return stepsToGo < maxSearchDepthForThisStep;
     }
 
+    double time = stopwatch();
+    recordStepTime(stepsToGo, time);
+
     // 1. If caching was disabled, we check if the strict timeout is violated to
     // readjust the maximal search depth
     if (ramLimitReached &&
@@ -312,6 +521,9 @@ void IDS::resetStats() {
     accumulatedSearchDepth = 0;
     cacheHits = 0;
     numberOfRuns = 0;
+    searchDepthIncreases = 0;
+    searchDepthDecreases = 0;
+    stepTime.clear();
 }
 
 void IDS::printStats(ostream& out, bool const& printRoundStats,
@@ -324,5 +536,21 @@ void IDS::printStats(ostream& out, bool const& printRoundStats,
             << " (in " << numberOfRuns << " runs)" << endl;
     }
     out << indent << "Maximal search depth: " << maxSearchDepth << endl;
+    for (size_t index = 2; index < stepTime.size(); ++index) {
+        vector<double> const& times = stepTime[index];
+        if (!times.empty()) {
+            double timeSum = std::accumulate(times.begin(), times.end(), 0.0);
+            out << indent << "Search depth " << index << ": "
+                << (timeSum / static_cast<double>(times.size())) << "s (in "
+                << times.size() << " runs)" << endl;
+        }
+    }
+    if (adaptSearchDepth) {
+        out << indent << "Search depth adaptations: " << searchDepthIncreases
+            << " increases, " << searchDepthDecreases << " decreases" << endl;
+    }
     out << indent << "Cache hits: " << cacheHits << endl;
+    if (useIncrementalSearch) {
+        dfs->printStats(out, printRoundStats, indent + "  ");
+    }
 }
@@ -17,6 +17,7 @@ class DepthFirstSearch;
 class IDS : public DeterministicSearchEngine {
 public:
     IDS();
+    ~IDS();
 
     // Set parameters from command line
     bool setValueFromString(std::string& param, std::string& value) override;
@@ -28,6 +29,14 @@ public:
     // set.
     void learn() override;
 
+    // Write and restore the maximal search depth that was determined in learn()
+    void writeLearnedParameters(std::ostream& out) const override;
+    bool readLearnedParameters(std::istream& in) override;
+
+    // This is called after each step to readjust the maximal search depth
+    // based on the time the iterations of that step needed
+    void finishStep() override;
+
     // Start the search engine to estimate the Q-value of a single action
     void estimateQValue(State const& state, int actionIndex,
                         double& qValue) override;
@@ -50,6 +59,20 @@ public:
         terminateWithReasonableAction = newValue;
     }
 
+    // If this is true, the graph explicated in an iteration of IDS is reused in
+    // the following iterations
+    void setUseIncrementalSearch(bool newValue);
+
+    void setAdaptSearchDepth(bool newValue) {
+        adaptSearchDepth = newValue;
+    }
+
+    // The number of threads that evaluate the training set during learning
+    // (0 means one thread per core)
+    void setNumberOfLearningThreads(int newValue) {
+        numberOfLearningThreads = newValue;
+    }
+
     // Reset statistic variables
     void resetStats();
 
@@ -71,6 +94,19 @@ protected:
                         std::vector<double>& qValues);
     inline bool moreIterations(int const& stepsToGo);
 
+    // Records the time that was needed to finish the iteration with stepsToGo
+    // remaining steps in the current step
+    void recordStepTime(int const& stepsToGo, double const& time);
+
+    // Returns the average time that was needed in the current step to finish
+    // iterations with stepsToGo remaining steps (or -1 if there are too few
+    // samples)
+    double getAverageStepTime(int const& stepsToGo) const;
+
+    // Performs IDS on every increment-th state of the training set, starting
+    // with the state with index firstIndex
+    void learnOnTrainingSet(size_t firstIndex, size_t increment);
+
     // The depth first search engine
     DepthFirstSearch* dfs;
 
@@ -78,9 +114,22 @@ protected:
     bool isLearning;
     std::vector<std::vector<double>> elapsedTime;
 
+    // Time needed for each search depth in the current step (used to readjust
+    // the maximal search depth between steps)
+    std::vector<std::vector<double>> stepTime;
+
+    // The maximal search depth is never increased beyond this value (i.e., the
+    // search depth that was set before learning)
+    int searchDepthLimit;
+
     // Stopwatch used to make sure that computation doesn't take too much time
     Stopwatch stopwatch;
 
+    // During learning, we measure the CPU time of the calling thread such that
+    // the times of the training set are neither distorted by other processes
+    // nor by the other learning threads
+    CPUStopwatch learningStopwatch;
+
     // The number of remaining steps for this step
     int maxSearchDepthForThisStep;
 
@@ -90,11 +139,16 @@ protected:
     // Parameter
     double strictTerminationTimeout;
     bool terminateWithReasonableAction;
+    bool useIncrementalSearch;
+    bool adaptSearchDepth;
+    int numberOfLearningThreads;
 
     // Statistics
     int accumulatedSearchDepth;
     int cacheHits;
     int numberOfRuns;
+    int searchDepthIncreases;
+    int searchDepthDecreases;
 };
 
 #endif
@@ -1,4 +1,5 @@
 #include "ippc_client.h"
+#include "offline_simulator.h"
 #include "parser.h"
 #include "prost_planner.h"
 
@@ -11,8 +12,50 @@
 using namespace std;
 
 void printUsage() {
-    cout << "Usage: ./prost <rddl-parser-output> [PROST <options>]" << endl
+    cout << "Usage: ./prost <rddl-parser-output> [<client options>] [PROST "
+            "<options>]"
+         << endl
+         << endl;
+
+    cout << "**************************************************************"
+         << endl
+         << "                        Client Options" << endl
+         << "**************************************************************"
+         << endl;
+
+    cout << "  -h, --hostname <string>" << endl;
+    cout << "    Specifies the host of the rddlsim server." << endl;
+    cout << "    Default: localhost" << endl << endl;
+
+    cout << "  -p, --port <int>" << endl;
+    cout << "    Specifies the port of the rddlsim server." << endl;
+    cout << "    Default: 2323" << endl << endl;
+
+    cout << "  -r, --rounds <int>" << endl;
+    cout << "    If this is given, PROST does not connect to rddlsim but "
+            "simulates the given number of rounds on the parsed task itself."
+         << endl;
+    cout << "    Default: 0 (i.e., rddlsim is used)" << endl << endl;
+
+    cout << "  --simulator-seed <int>" << endl;
+    cout << "    Specifies the seed of the offline simulator (which is "
+            "independent from the seed of the planner)."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  --time-per-step <double>" << endl;
+    cout << "    Specifies the time in seconds per step that the offline "
+            "simulator allows the planner (this only matters if the planner "
+            "manages timeouts)."
+         << endl;
+    cout << "    Default: 1.0" << endl << endl;
+
+    cout << "  --simulator-latency <double>" << endl;
+    cout << "    Specifies the time in seconds the offline simulator waits "
+            "after each action (as if the next state was computed by "
+            "rddlsim), which the planner can use for pondering."
          << endl;
+    cout << "    Default: 0.0" << endl << endl << endl;
 
     cout << "**************************************************************"
          << endl
@@ -35,6 +78,71 @@ void printUsage() {
          << endl;
     cout << "    Default: sizeof(long)*8" << endl << endl;
 
+    cout << "  -tm <NONE | UNI | ADA>" << endl;
+    cout << "    Specifies how the remaining time is distributed among the "
+            "steps. With NONE, the timeout of the search engine is used in "
+            "each step. With UNI, each remaining step gets the same share of "
+            "the remaining time. With ADA, steps close to the horizon get "
+            "less time, and THTS stops early if the best action in the root "
+            "is stable and clearly better than the others, or continues up to "
+            "three times as long if it is not."
+         << endl;
+    cout << "    Default: NONE" << endl << endl;
+
+    cout << "  -lf <file>" << endl;
+    cout << "    Specifies a file where learned parameters and cached values "
+            "are stored at the end of the session. If the file exists and "
+            "was written for the same task and search engine, learning is "
+            "skipped and the search starts with the stored values."
+         << endl;
+    cout << "    Default: None" << endl << endl;
+
+    cout << "  -pt <0|1>" << endl;
+    cout << "    Measures the time spent in each phase of the THTS trials "
+            "(action and outcome selection, successor computation, "
+            "initialization, backups, reward lock detection, cache lookups "
+            "and abstraction). The times are printed with the statistics of "
+            "each step and as JSON object at the end of the session."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  -ponder <0|1>" << endl;
+    cout << "    Continues the search in the subtree of the submitted action "
+            "while the next state is computed, and starts the search of the "
+            "next step with the subtree of the next state (only supported "
+            "by THTS search engines)."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  -book <double>" << endl;
+    cout << "    Creates an opening book before the first round: the initial "
+            "state and the most likely states of the following steps (if the "
+            "best actions are applied) are searched for the given number of "
+            "seconds each, and the decisions in these states are taken from "
+            "the book without search (0 disables the book)."
+         << endl;
+    cout << "    Default: 0.0" << endl << endl;
+
+    cout << "  -bd <int>" << endl;
+    cout << "    Specifies the number of steps with a state in the opening "
+            "book."
+         << endl;
+    cout << "    Default: 3" << endl << endl;
+
+    cout << "  -sf <file>" << endl;
+    cout << "    Writes the statistics of each step (e.g., trials, search "
+            "nodes, search and abstraction time, and the Q-values of the "
+            "root actions) and each round to a file, one JSON object per "
+            "line."
+         << endl;
+    cout << "    Default: None" << endl << endl;
+
+    cout << "  -q <0|1>" << endl;
+    cout << "    Suppresses all output of the search engine during the "
+            "search."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
     cout << "  -se <SearchEngine>" << endl;
     cout << "    Specifies the used main search engine." << endl;
     cout << "    MANDATORY." << endl << endl << endl;
@@ -93,7 +201,28 @@ void printUsage() {
             "If learning determines a lower search depth than this, it is set "
             "to 0 instead."
          << endl;
-    cout << "    Default: 2" << endl << endl << endl;
+    cout << "    Default: 2" << endl << endl;
+
+    cout << "  -inc <0|1>" << endl;
+    cout << "    Specifies if the graph that is explicated in an iteration is "
+            "kept for the following iterations, such that only the new "
+            "frontier has to be generated when the search depth is increased."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  -ad <0|1>" << endl;
+    cout << "    Specifies if the maximal search depth is readjusted after each "
+            "step based on the time the iterations of that step needed, such "
+            "that the timeout (-t) is met on average."
+         << endl;
+    cout << "    Default: 1" << endl << endl;
+
+    cout << "  -lt <int>" << endl;
+    cout << "    Specifies the number of threads that perform IDS on the "
+            "states of the training set during learning (0 means one thread "
+            "per core)."
+         << endl;
+    cout << "    Default: 0" << endl << endl << endl;
 
     cout << "**************** Depth First Search **********************"
          << endl;
@@ -213,6 +342,15 @@ void printUsage() {
          << endl;
     cout << "    Default: 24000000" << endl << endl;
 
+    cout << "  -recycle <double>" << endl;
+    cout << "    If this is larger than 0, the search does not stop when the "
+            "node limit is reached. Instead, the least visited subtrees "
+            "(and solved subtrees first) are released until the given "
+            "fraction of the node limit is available. The action nodes "
+            "above the released subtrees keep their value estimates."
+         << endl;
+    cout << "    Default: 0.0" << endl << endl;
+
     cout << "  -sd <int>" << endl;
     cout << "    Specifies the considered horizon." << endl;
     cout << "    Default: Horizon of the task" << endl << endl;
@@ -237,6 +375,78 @@ void printUsage() {
          << endl;
     cout << "    Default: 0" << endl << endl;
 
+    cout << "  -stab <int>" << endl;
+    cout << "    Stops the search early if the best action in the root node "
+            "has not changed in the given number of trials (0 disables this "
+            "rule). This applies in addition to the termination criterion, "
+            "and the saved time is used in later steps."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  -conf <double>" << endl;
+    cout << "    Stops the search early if the Q-value of the best action in "
+            "the root node is larger than the one of the second best action "
+            "with high confidence, i.e., if the intervals of width c * |Q| / "
+            "sqrt(visits) around both Q-values are disjoint, where c is the "
+            "given factor (0 disables this rule)."
+         << endl;
+    cout << "    Default: 0.0" << endl << endl;
+
+    cout << "  -tst <double>" << endl;
+    cout << "    If this is larger than 0, decision nodes close to the horizon "
+            "are solved exactly by an expectimax search over the real "
+            "transition distributions. The number of remaining steps up to "
+            "which nodes are solved is adapted automatically to the "
+            "branching factor, such that a single call takes at most the "
+            "given number of seconds."
+         << endl;
+    cout << "    Default: 0.0" << endl << endl;
+
+    cout << "  -tt <0|1>" << endl;
+    cout << "    Specifies if transpositions are used. If this is switched on, "
+            "all decision nodes of the same state (with the same number of "
+            "remaining steps) share the children of the first one that is "
+            "initialized in the current step, so the search tree becomes a "
+            "DAG where visits and values are shared."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  -jo <0|1>" << endl;
+    cout << "    Specifies if the outcome of an action is sampled for all "
+            "probabilistic state fluents at once, such that the children of "
+            "an action node are the decision nodes of the sampled successor "
+            "states (which are found by the hash key of the state), instead "
+            "of building a layer of chance nodes for each probabilistic "
+            "state fluent. This requires state hashing, and trees with joint "
+            "outcomes are neither pondered nor kept for later rounds."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  -mt <int>" << endl;
+    cout << "    Specifies the maximal number of successor distributions that "
+            "are memoized in the action nodes in each step, such that later "
+            "trials through the node only sample the outcome (0 disables "
+            "memoization)."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  -kt <int>" << endl;
+    cout << "    Specifies the maximal number of search nodes of trees that are "
+            "kept for later rounds (0 disables this). The trees of the root "
+            "states of the first steps of a round are kept, and the search "
+            "continues in the kept tree when its state is the root state "
+            "again. If the budget is exceeded, the trees of states that have "
+            "been visited less often are discarded first."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
+    cout << "  -kts <int>" << endl;
+    cout << "    Specifies the number of steps at the beginning of a round "
+            "whose trees are kept (if -kt is used), i.e., 1 only keeps the "
+            "tree of the initial state."
+         << endl;
+    cout << "    Default: 1" << endl << endl;
+
     cout << "  -ndn <int|H>" << endl;
     cout << "    This is the parameter that describes the trial length "
             "ingredient. It specifies the number of previously unvisited "
@@ -314,6 +524,17 @@ void printUsage() {
          << endl
          << endl;
 
+    cout << "All backup functions support the following option:" << endl;
+
+    cout << "  -ib <0|1>" << endl;
+    cout << "    Specifies if incremental backups are used. If this is switched "
+            "on, a node is updated with the change of the child that has been "
+            "visited in the trial instead of considering all its children. "
+            "Decision nodes only consider all children if the value of the "
+            "best child decreases or if a child is solved."
+         << endl;
+    cout << "    Default: 0" << endl << endl;
+
     cout << "*************************** MC ***************************"
          << endl;
 
@@ -366,7 +587,7 @@ void printUsage() {
 
     cout << "The MaxMonte-Carlo backup function is just like MC, except that "
             "decision nodes are updated by maximization over all actions. It "
-            "is created by [MaxMC] and has no options."
+            "is created by [MaxMC <options>] and has no further options."
          << endl
          << endl;
 
@@ -375,8 +596,8 @@ void printUsage() {
 
     cout << "The PB backup function is a partial variant of the Bellman backup "
             "function that can be applied even if some chance node successors "
-            "of a decision node are not yet explicated.  It is created by [PB] "
-            "and has no options."
+            "of a decision node are not yet explicated.  It is created by "
+            "[PB <options>] and has no further options."
          << endl
          << endl;
 
@@ -557,6 +778,10 @@ int main(int argc, char** argv) {
     // init optionals to default values
     string hostName = "localhost";
     unsigned short port = 2323;
+    int numberOfSimulatedRounds = 0;
+    int simulatorSeed = 0;
+    double timePerStep = 1.0;
+    double simulatorLatency = 0.0;
 
     bool allParamsRead = false;
     string plannerDesc;
@@ -572,6 +797,14 @@ int main(int argc, char** argv) {
                 hostName = string(argv[++i]);
             } else if (nextOption == "-p" || nextOption == "--port") {
                 port = (unsigned short)(atoi(string(argv[++i]).c_str()));
+            } else if (nextOption == "-r" || nextOption == "--rounds") {
+                numberOfSimulatedRounds = atoi(string(argv[++i]).c_str());
+            } else if (nextOption == "--simulator-seed") {
+                simulatorSeed = atoi(string(argv[++i]).c_str());
+            } else if (nextOption == "--time-per-step") {
+                timePerStep = atof(string(argv[++i]).c_str());
+            } else if (nextOption == "--simulator-latency") {
+                simulatorLatency = atof(string(argv[++i]).c_str());
             } else {
                 cerr << "Unknown option: " << nextOption << endl;
                 printUsage();
@@ -590,11 +823,19 @@ int main(int argc, char** argv) {
     ProstPlanner* planner = new ProstPlanner(plannerDesc);
     planner->init();
 
-    // Create connector to rddlsim and run
-    IPPCClient* client = new IPPCClient(
-        planner, hostName, port, stateVariableIndices, stateVariableValues);
-
-    client->run(SearchEngine::taskName);
+    if (numberOfSimulatedRounds > 0) {
+        // Simulate the task without rddlsim
+        OfflineSimulator simulator(planner, numberOfSimulatedRounds,
+                                   simulatorSeed, timePerStep,
+                                   simulatorLatency);
+        simulator.run();
+    } else {
+        // Create connector to rddlsim and run
+        IPPCClient* client = new IPPCClient(
+            planner, hostName, port, stateVariableIndices, stateVariableValues);
+
+        client->run(SearchEngine::taskName);
+    }
 
     cout << "PROST complete running time: " << totalTime << endl;
     return 0;
@@ -0,0 +1,144 @@
+#include "offline_simulator.h"
+
+#include "prost_planner.h"
+#include "search_engine.h"
+
+#include "utils/stopwatch.h"
+#include "utils/system_utils.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+// Concatenates the sorted names such that the order of the action fluents does
+// not matter
+static string actionDescription(vector<string> names) {
+    sort(names.begin(), names.end());
+    string result;
+    for (size_t i = 0; i < names.size(); ++i) {
+        result += names[i] + " ";
+    }
+    return result;
+}
+
+OfflineSimulator::OfflineSimulator(ProstPlanner* _planner, int _numberOfRounds,
+                                   int _seed, double _timePerStep,
+                                   double _latency)
+    : planner(_planner),
+      numberOfRounds(_numberOfRounds),
+      remainingTime(static_cast<long>(_timePerStep * 1000.0) *
+                    _numberOfRounds * SearchEngine::horizon),
+      latency(_latency) {
+    rnd.seed(_seed);
+
+    for (size_t index = 0; index < SearchEngine::actionStates.size();
+         ++index) {
+        ActionState const& action = SearchEngine::actionStates[index];
+        vector<string> names;
+        for (size_t i = 0; i < action.scheduledActionFluents.size(); ++i) {
+            names.push_back(action.scheduledActionFluents[i]->name);
+        }
+        actionIndices[actionDescription(names)] = index;
+    }
+}
+
+void OfflineSimulator::run() {
+    planner->initSession(numberOfRounds, remainingTime);
+
+    double totalReward = 0.0;
+    for (int round = 0; round < numberOfRounds; ++round) {
+        totalReward += playRound();
+    }
+
+    planner->finishSession(totalReward);
+}
+
+double OfflineSimulator::playRound() {
+    planner->initRound(remainingTime);
+
+    State current(SearchEngine::initialState);
+    State next;
+    double roundReward = 0.0;
+    for (int stepsToGo = SearchEngine::horizon; stepsToGo > 0; --stepsToGo) {
+        Stopwatch stepTime;
+        planner->initStep(toStateVector(current), remainingTime);
+        int actionIndex = getActionIndex(planner->plan());
+        remainingTime -= static_cast<long>(stepTime() * 1000.0);
+
+        Stopwatch latencyTime;
+        while ((latencyTime() < latency) && planner->ponder()) {
+        }
+
+        double immediateReward =
+            sampleSuccessorState(current, actionIndex, next);
+        roundReward += immediateReward;
+        planner->finishStep(immediateReward);
+        current.swap(next);
+    }
+
+    planner->finishRound(roundReward);
+    return roundReward;
+}
+
+int OfflineSimulator::getActionIndex(
+    vector<string> const& actionFluentNames) const {
+    map<string, int>::const_iterator it =
+        actionIndices.find(actionDescription(actionFluentNames));
+    if (it == actionIndices.end()) {
+        SystemUtils::abort("Error: planner submitted an unknown action.");
+    }
+    return it->second;
+}
+
+double OfflineSimulator::sampleSuccessorState(State const& current,
+                                              int const& actionIndex,
+                                              State& next) {
+    ActionState const& action = SearchEngine::actionStates[actionIndex];
+    next.reset(current.stepsToGo() - 1);
+
+    double reward = 0.0;
+    SearchEngine::rewardCPF->evaluate(reward, current, action);
+
+    for (int index = 0; index < State::numberOfDeterministicStateFluents;
+         ++index) {
+        SearchEngine::deterministicCPFs[index]->evaluate(
+            next.deterministicStateFluent(index), current, action);
+    }
+
+    for (int index = 0; index < State::numberOfProbabilisticStateFluents;
+         ++index) {
+        DiscretePD pd;
+        SearchEngine::probabilisticCPFs[index]->evaluate(pd, current, action);
+        assert(pd.isWellDefined());
+
+        // Sample with our own random number generator to be independent of
+        // the random decisions of the planner
+        double randNum = rnd.genReal();
+        double probSum = 0.0;
+        double& value = next.probabilisticStateFluent(index);
+        value = pd.values.back();
+        for (size_t i = 0; i < pd.values.size(); ++i) {
+            probSum += pd.probabilities[i];
+            if (MathUtils::doubleIsSmaller(randNum, probSum)) {
+                value = pd.values[i];
+                break;
+            }
+        }
+    }
+
+    State::calcStateFluentHashKeys(next);
+    State::calcStateHashKey(next);
+    return reward;
+}
+
+vector<double> OfflineSimulator::toStateVector(State const& state) const {
+    vector<double> result;
+    for (int i = 0; i < State::numberOfDeterministicStateFluents; ++i) {
+        result.push_back(state.deterministicStateFluent(i));
+    }
+    for (int i = 0; i < State::numberOfProbabilisticStateFluents; ++i) {
+        result.push_back(state.probabilisticStateFluent(i));
+    }
+    return result;
+}
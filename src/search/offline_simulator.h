@@ -0,0 +1,61 @@
+#ifndef OFFLINE_SIMULATOR_H
+#define OFFLINE_SIMULATOR_H
+
+// Simulates sessions on the parsed task without the rddlsim server. States are
+// sampled from the CPFs of the task with a random number generator that is
+// independent from the planner's, so runs with the same seeds are
+// reproducible. As the planner is driven with the same calls as by the
+// IPPCClient, this can be used as a local replacement of rddlsim for
+// experiments.
+
+#include "states.h"
+
+#include "utils/random.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+class ProstPlanner;
+
+class OfflineSimulator {
+public:
+    OfflineSimulator(ProstPlanner* _planner, int _numberOfRounds, int _seed,
+                     double _timePerStep, double _latency);
+
+    void run();
+
+private:
+    // Plays a single round and returns the accumulated reward
+    double playRound();
+
+    // Returns the index of the action that consists of the given action
+    // fluents (aborts if there is no such action)
+    int getActionIndex(std::vector<std::string> const& actionFluentNames) const;
+
+    // Applies the action with index actionIndex to current by sampling each
+    // probabilistic state fluent, and returns the immediate reward
+    double sampleSuccessorState(State const& current, int const& actionIndex,
+                                State& next);
+
+    // Returns the state as vector in the format that is used by ProstPlanner
+    std::vector<double> toStateVector(State const& state) const;
+
+    ProstPlanner* planner;
+    int numberOfRounds;
+
+    // The remaining time (in milliseconds) that is passed to the planner
+    long remainingTime;
+
+    // The time (in seconds) the simulated server needs to respond to an action,
+    // which the planner may use for pondering
+    double latency;
+
+    RandomMT rnd;
+
+    // Maps the sorted and concatenated names of all action fluents of an action
+    // state to its index
+    std::map<std::string, int> actionIndices;
+};
+
+#endif
@@ -80,6 +80,31 @@ SearchNode* MCOutcomeSelection::selectOutcome(SearchNode* node,
     return node->children[childIndex];
 }
 
+SearchNode* MCOutcomeSelection::selectJointOutcome(SearchNode* node,
+                                                   PDState& nextState,
+                                                   int lastProbVarIndex) {
+    for (int i = 1;; ++i) {
+        double prob = 1.0;
+        for (int varIndex = 0; varIndex <= lastProbVarIndex; ++varIndex) {
+            if (!nextState.probabilisticStateFluentAsPD(varIndex)
+                     .isDeterministic()) {
+                prob *= nextState.sample(varIndex).second;
+            }
+        }
+        State::calcStateHashKey(nextState);
+
+        SearchNode*& child =
+            thts->getJointOutcome(node, nextState.getHashKey());
+        if (!child) {
+            child = thts->createDecisionNode(prob);
+            node->children.push_back(child);
+            return child;
+        } else if (!isIgnored(child) || (i == maxNumberOfJointSamples)) {
+            return child;
+        }
+    }
+}
+
 /******************************************************************
              MC Outcome Selection with Solve Labeling
 ******************************************************************/
@@ -97,3 +122,7 @@ vector<int> UnsolvedMCOutcomeSelection::computeBlacklist(
     }
     return blacklist;
 }
+
+bool UnsolvedMCOutcomeSelection::isIgnored(SearchNode* child) const {
+    return child->solved;
+}
@@ -32,6 +32,12 @@ public:
     virtual SearchNode* selectOutcome(SearchNode* node, PDState& nextState,
                                       int varIndex, int lastProbVarIndex) = 0;
 
+    // Outcome selection of all probabilistic state fluents at once if THTS
+    // uses joint outcomes. The hash key of nextState is computed.
+    virtual SearchNode* selectJointOutcome(SearchNode* node,
+                                           PDState& nextState,
+                                           int lastProbVarIndex) = 0;
+
     // Prints statistics
     virtual void printStats(std::ostream& /*out*/, std::string /*indent*/) {}
 
@@ -48,6 +54,9 @@ public:
     SearchNode* selectOutcome(SearchNode* node, PDState& nextState,
                               int varIndex, int lastProbVarIndex) override;
 
+    SearchNode* selectJointOutcome(SearchNode* node, PDState& nextState,
+                                   int lastProbVarIndex) override;
+
     // A blacklist indicates which values are ignored for outcome selection.
     // Basic MC Sampling does not ignore any values.
     virtual std::vector<int> computeBlacklist(SearchNode* /*node*/,
@@ -55,6 +64,16 @@ public:
                                               int /*varIndex*/) const {
         return std::vector<int>{};
     }
+
+    // Joint outcomes cannot be blacklisted before they are sampled, so an
+    // outcome is sampled again (up to maxNumberOfJointSamples times) if it is
+    // ignored (and if the last sample is solved, THTS treats it as a leaf).
+    // Basic MC Sampling does not ignore any outcomes.
+    virtual bool isIgnored(SearchNode* /*child*/) const {
+        return false;
+    }
+
+    static int const maxNumberOfJointSamples = 10;
 };
 
 class UnsolvedMCOutcomeSelection : public MCOutcomeSelection {
@@ -65,6 +84,9 @@ public:
     std::vector<int> computeBlacklist(SearchNode* node,
                                       PDState const& nextState,
                                       int varIndex) const override;
+
+    // Solved outcomes are ignored
+    bool isIgnored(SearchNode* child) const override;
 };
 
 #endif
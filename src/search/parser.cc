@@ -17,6 +17,7 @@ void Parser::parseTask(map<string, int>& stateVariableIndices,
     }
     stringstream desc(problemDesc);
     resetStatics();
+    SearchEngine::taskHash = StringUtils::computeHash(problemDesc);
     // Parse general task properties
     desc >> SearchEngine::taskName;
     desc >> SearchEngine::horizon;
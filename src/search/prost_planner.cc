@@ -2,18 +2,153 @@
 
 #include "search_engine.h"
 
-//#include "iterative_deepening_search.h"
-//#include "minimal_lookahead_search.h"
+#include "iterative_deepening_search.h"
+#include "minimal_lookahead_search.h"
 
 #include "utils/math_utils.h"
+#include "utils/phase_timer.h"
+#include "utils/stats_sink.h"
 #include "utils/stopwatch.h"
 #include "utils/string_utils.h"
 #include "utils/system_utils.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <unistd.h>
 
 using namespace std;
 
+/******************************************************************
+                   Learned data file helper functions
+******************************************************************/
+
+// The file starts with this tag and version, which must be increased whenever
+// the format changes
+static char const learnedDataTag[8] = "PROSTLD";
+static unsigned int const learnedDataVersion = 2;
+
+template <typename T>
+static void writeValue(ostream& out, T const& value) {
+    out.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+// Returns the number of bytes that have not been read yet, which bounds all
+// sizes that are read such that a corrupt file is rejected instead of causing
+// a huge allocation
+static size_t getRemainingBytes(istream& in) {
+    streampos pos = in.tellg();
+    in.seekg(0, ios::end);
+    streampos end = in.tellg();
+    in.seekg(pos);
+    if ((pos < 0) || (end < pos)) {
+        return 0;
+    }
+    return static_cast<size_t>(end - pos);
+}
+
+static void writeValue(ostream& out, string const& value) {
+    writeValue(out, value.size());
+    out.write(value.c_str(), value.size());
+}
+
+static bool readValue(istream& in, string& value) {
+    size_t size = 0;
+    if (!readValue(in, size) || (size > getRemainingBytes(in))) {
+        return false;
+    }
+    value.resize(size);
+    return (size == 0) || in.read(&value[0], size);
+}
+
+static void writeValue(ostream& out, vector<double> const& value) {
+    writeValue(out, value.size());
+    out.write(reinterpret_cast<char const*>(value.data()),
+              value.size() * sizeof(double));
+}
+
+static bool readValue(istream& in, vector<double>& value) {
+    size_t size = 0;
+    if (!readValue(in, size) || (size != SearchEngine::numberOfActions)) {
+        return false;
+    }
+    value.resize(size);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(value.data()),
+                                     size * sizeof(double)));
+}
+
+static void writeValue(ostream& out, State const& state) {
+    writeValue(out, state.stepsToGo());
+    for (int i = 0; i < State::numberOfDeterministicStateFluents; ++i) {
+        writeValue(out, state.deterministicStateFluent(i));
+    }
+    for (int i = 0; i < State::numberOfProbabilisticStateFluents; ++i) {
+        writeValue(out, state.probabilisticStateFluent(i));
+    }
+}
+
+static bool readValue(istream& in, State& state) {
+    int stepsToGo = 0;
+    if (!readValue(in, stepsToGo) || (stepsToGo < 0) ||
+        (stepsToGo > SearchEngine::horizon)) {
+        return false;
+    }
+    state.reset(stepsToGo);
+    for (int i = 0; i < State::numberOfDeterministicStateFluents; ++i) {
+        if (!readValue(in, state.deterministicStateFluent(i))) {
+            return false;
+        }
+    }
+    for (int i = 0; i < State::numberOfProbabilisticStateFluents; ++i) {
+        if (!readValue(in, state.probabilisticStateFluent(i))) {
+            return false;
+        }
+    }
+    State::calcStateFluentHashKeys(state);
+    State::calcStateHashKey(state);
+    return true;
+}
+
+template <typename HashMap>
+static void writeCache(ostream& out, HashMap const& cache) {
+    writeValue(out, cache.size());
+    for (typename HashMap::const_iterator it = cache.begin();
+         it != cache.end(); ++it) {
+        writeValue(out, it->first);
+        writeValue(out, it->second);
+    }
+}
+
+template <typename HashMap>
+static bool readCache(istream& in, HashMap& cache) {
+    // Each entry contains at least a state
+    size_t stateSize = sizeof(int) +
+                       (State::numberOfDeterministicStateFluents +
+                        State::numberOfProbabilisticStateFluents) *
+                           sizeof(double);
+    size_t size = 0;
+    if (!readValue(in, size) || (size > getRemainingBytes(in) / stateSize)) {
+        return false;
+    }
+    cache.reserve(cache.size() + size);
+    for (size_t i = 0; i < size; ++i) {
+        State state;
+        typename HashMap::mapped_type value;
+        if (!readValue(in, state) || !readValue(in, value)) {
+            return false;
+        }
+        cache[state] = value;
+    }
+    return true;
+}
+
 ProstPlanner::ProstPlanner(string& plannerDesc)
     : searchEngine(nullptr),
       currentState(SearchEngine::initialState),
@@ -24,7 +159,12 @@ ProstPlanner::ProstPlanner(string& plannerDesc)
       cachingEnabled(true),
       ramLimit(2097152),
       bitSize(sizeof(long) * 8),
-      tmMethod(NONE) {
+      tmMethod(NONE),
+      ponderingEnabled(false),
+      bookTimePerState(0.0),
+      bookDepth(3),
+      bookAnswer(false),
+      numberOfBookAnswers(0) {
     setSeed((int)time(nullptr));
 
     StringUtils::trim(plannerDesc);
@@ -53,11 +193,31 @@ ProstPlanner::ProstPlanner(string& plannerDesc)
                 setTimeoutManagementMethod(UNIFORM);
             } else if (value == "NONE") {
                 setTimeoutManagementMethod(NONE);
+            } else if (value == "ADA") {
+                setTimeoutManagementMethod(ADAPTIVE);
             } else {
                 SystemUtils::abort("Illegal timeout management method: " +
                                    value);
             }
+        } else if (param == "-lf") {
+            setLearnedDataFile(value);
+        } else if (param == "-pt") {
+            PhaseTimer::setEnabled(atoi(value.c_str()));
+        } else if (param == "-ponder") {
+            setPonderingEnabled(atoi(value.c_str()));
+        } else if (param == "-book") {
+            setBookTimePerState(atof(value.c_str()));
+        } else if (param == "-bd") {
+            setBookDepth(atoi(value.c_str()));
+        } else if (param == "-sf") {
+            if (!StatsSink::open(value)) {
+                SystemUtils::abort("Error: cannot open statistics file " +
+                                   value);
+            }
+        } else if (param == "-q") {
+            SearchEngine::quiet = atoi(value.c_str());
         } else if (param == "-se") {
+            searchEngineDesc = value;
             setSearchEngine(SearchEngine::fromString(value));
             searchEngineDefined = true;
         } else {
@@ -83,7 +243,9 @@ void ProstPlanner::init() {
 
     cout.precision(6);
 
-    searchEngine->learn();
+    if (learnedDataFile.empty() || !readLearnedData()) {
+        searchEngine->learn();
+    }
 
     if (searchEngine->usesBDDs()) {
         // TODO: These numbers are rather random. Since I know only little on
@@ -102,12 +264,107 @@ void ProstPlanner::init() {
     SearchEngine::printTask(cout);
 
     cout.precision(6);
+
+    if (MathUtils::doubleIsGreater(bookTimePerState, 0.0)) {
+        createOpeningBook();
+    }
+}
+
+void ProstPlanner::createOpeningBook() {
+    Stopwatch time;
+    cout << "creating opening book..." << endl;
+
+    double timeout = searchEngine->getTimeout();
+    double maxTimeout = searchEngine->getMaxTimeout();
+    searchEngine->setTimeout(bookTimePerState);
+    searchEngine->setMaxTimeout(0.0);
+
+    // The state is built from the fluents like the states that are received
+    // from the environment (the hash keys of the initial state are computed
+    // while parsing)
+    State const& initialState = SearchEngine::initialState;
+    vector<double> deterministicStateFluents;
+    for (int i = 0; i < State::numberOfDeterministicStateFluents; ++i) {
+        deterministicStateFluents.push_back(
+            initialState.deterministicStateFluent(i));
+    }
+    vector<double> probabilisticStateFluents;
+    for (int i = 0; i < State::numberOfProbabilisticStateFluents; ++i) {
+        probabilisticStateFluents.push_back(
+            initialState.probabilisticStateFluent(i));
+    }
+    State state(deterministicStateFluents, probabilisticStateFluents,
+                SearchEngine::horizon);
+    State::calcStateFluentHashKeys(state);
+    State::calcStateHashKey(state);
+
+    // The book is computed like the first steps of a round
+    searchEngine->initRound();
+    for (int depth = 0; depth < bookDepth; ++depth) {
+        // The decision in the last step is computed without search anyway
+        if ((state.stepsToGo() <= 1) || (book.find(state) != book.end())) {
+            break;
+        }
+        vector<int> bestActions;
+        estimateBestActions(state, bestActions);
+        book[state] = bestActions;
+        state = getMostLikelySuccessor(state, bestActions[0]);
+    }
+
+    searchEngine->setTimeout(timeout);
+    searchEngine->setMaxTimeout(maxTimeout);
+    cout << "...finished with " << book.size() << " states (" << time << ")."
+         << endl
+         << endl;
+}
+
+State ProstPlanner::getMostLikelySuccessor(State const& state,
+                                           int actionIndex) const {
+    ActionState const& action = SearchEngine::actionStates[actionIndex];
+    vector<double> deterministicStateFluents(
+        State::numberOfDeterministicStateFluents);
+    for (int i = 0; i < State::numberOfDeterministicStateFluents; ++i) {
+        SearchEngine::deterministicCPFs[i]->evaluate(
+            deterministicStateFluents[i], state, action);
+    }
+    // The probabilistic state fluents are independent, so the most likely
+    // state consists of the most likely value of each of them
+    vector<double> probabilisticStateFluents(
+        State::numberOfProbabilisticStateFluents);
+    for (int i = 0; i < State::numberOfProbabilisticStateFluents; ++i) {
+        DiscretePD pd;
+        SearchEngine::probabilisticCPFs[i]->evaluate(pd, state, action);
+        assert(!pd.values.empty());
+        size_t mostLikely = 0;
+        for (size_t j = 1; j < pd.values.size(); ++j) {
+            if (MathUtils::doubleIsGreater(pd.probabilities[j],
+                                           pd.probabilities[mostLikely])) {
+                mostLikely = j;
+            }
+        }
+        probabilisticStateFluents[i] = pd.values[mostLikely];
+    }
+
+    // The hash keys are accumulated, so they must be computed for a new state
+    State successor(deterministicStateFluents, probabilisticStateFluents,
+                    state.stepsToGo() - 1);
+    State::calcStateFluentHashKeys(successor);
+    State::calcStateHashKey(successor);
+    return successor;
 }
 
 vector<string> ProstPlanner::plan() {
-    // Call the search engine
+    // Answer from the opening book or call the search engine
     vector<int> bestActions;
-    searchEngine->estimateBestActions(currentState, bestActions);
+    OpeningBook::const_iterator it = book.find(currentState);
+    bookAnswer = (it != book.end());
+    if (bookAnswer) {
+        cout << "Taking decision from opening book." << endl;
+        bestActions = it->second;
+        ++numberOfBookAnswers;
+    } else {
+        estimateBestActions(currentState, bestActions);
+    }
     chosenActionIndices[currentRound][currentStep] =
         MathUtils::rnd->randomElement(bestActions);
 
@@ -123,11 +380,48 @@ vector<string> ProstPlanner::plan() {
                              ->name);
     }
 
+    // The statistics of the search are recorded before they are changed by
+    // pondering, and the record is written when the reward is known
+    if (StatsSink::isOpen()) {
+        stepRecord.reset(new StatsRecord("step"));
+        stepRecord->add("round", currentRound + 1);
+        stepRecord->add("step", currentStep + 1);
+        stepRecord->add("action", chosenActionIndex);
+        stepRecord->add("book", bookAnswer ? 1 : 0);
+        if (!bookAnswer) {
+            searchEngine->collectStepStats(*stepRecord);
+        }
+    }
+
     // assert(false);
     // SystemUtils::abort("");
     return result;
 }
 
+void ProstPlanner::estimateBestActions(State const& state,
+                                       vector<int>& bestActions) {
+    if (SearchEngine::quiet) {
+        // Discard all output of the search engine (a stream without buffer
+        // writes nothing, and its state is cleared when the buffer is reset)
+        streambuf* coutBuffer = cout.rdbuf(nullptr);
+        searchEngine->estimateBestActions(state, bestActions);
+        cout.rdbuf(coutBuffer);
+    } else {
+        searchEngine->estimateBestActions(state, bestActions);
+    }
+}
+
+bool ProstPlanner::ponder() {
+    // The search engine has not searched the current state if the decision
+    // is taken from the book
+    if (!ponderingEnabled || bookAnswer) {
+        return false;
+    }
+    // The slice is short such that the next state is processed without delay
+    return searchEngine->ponder(chosenActionIndices[currentRound][currentStep],
+                                0.005);
+}
+
 void ProstPlanner::initSession(int _numberOfRounds, long /*totalTime*/) {
     currentRound = -1;
     numberOfRounds = _numberOfRounds;
@@ -138,6 +432,7 @@ void ProstPlanner::initSession(int _numberOfRounds, long /*totalTime*/) {
 
     switch (tmMethod) {
     case NONE:
+    case ADAPTIVE:
         break;
     case UNIFORM:
         remainingTimeFactor = numberOfRounds * SearchEngine::horizon;
@@ -161,9 +456,126 @@ void ProstPlanner::finishSession(double& totalReward) {
 
     double avgReward = totalReward / (double)numberOfRounds;
 
+    if (!book.empty()) {
+        cout << "Decisions taken from opening book: " << numberOfBookAnswers
+             << endl
+             << endl;
+    }
+
     cout << ">>>           TOTAL REWARD: " << totalReward << endl
          << ">>>          AVERAGE REWARD: " << avgReward << endl
          << "***********************************************" << endl;
+
+    if (PhaseTimer::isEnabled()) {
+        cout << ">>>            PHASE TIMES: ";
+        PhaseTimer::printSessionSummary(cout);
+    }
+
+    if (!learnedDataFile.empty()) {
+        writeLearnedData();
+    }
+}
+
+bool ProstPlanner::readLearnedData() {
+    ifstream in(learnedDataFile.c_str(), ios::binary);
+    if (!in) {
+        cout << "No learned data found in " << learnedDataFile << "." << endl;
+        return false;
+    }
+
+    char tag[sizeof(learnedDataTag)];
+    unsigned int version = 0;
+    unsigned long long taskHash = 0;
+    string desc;
+    if (!in.read(tag, sizeof(tag)) ||
+        (string(tag, sizeof(tag)) !=
+         string(learnedDataTag, sizeof(learnedDataTag))) ||
+        !readValue(in, version) || (version != learnedDataVersion) ||
+        !readValue(in, taskHash) || (taskHash != SearchEngine::taskHash) ||
+        !readValue(in, desc) || (desc != searchEngineDesc)) {
+        cout << "Learned data in " << learnedDataFile
+             << " belongs to another task, search engine or version." << endl;
+        return false;
+    }
+
+    // Everything is read into temporaries first and only applied once the
+    // whole file has been read successfully, such that learning can still be
+    // performed on an unmodified search engine if the file is corrupt. The
+    // parameters of the search engine are stored as a blob as the search
+    // engine can only interpret them by applying them.
+    string parameters;
+    SearchEngine::StateValueHashMap deterministicStateValueCache;
+    SearchEngine::StateValueHashMap probabilisticStateValueCache;
+    IDS::HashMap idsRewardCache;
+    MinimalLookaheadSearch::HashMap minimalLookaheadRewardCache;
+    if (!readValue(in, parameters) ||
+        !readCache(in, deterministicStateValueCache) ||
+        !readCache(in, probabilisticStateValueCache) ||
+        !readCache(in, idsRewardCache) ||
+        !readCache(in, minimalLookaheadRewardCache) ||
+        (in.peek() != char_traits<char>::eof())) {
+        cout << "Learned data in " << learnedDataFile << " is corrupt." << endl;
+        return false;
+    }
+
+    istringstream parametersIn(parameters);
+    if (!searchEngine->readLearnedParameters(parametersIn)) {
+        cout << "Learned data in " << learnedDataFile
+             << " contains invalid parameters." << endl;
+        return false;
+    }
+    DeterministicSearchEngine::stateValueCache.insert(
+        deterministicStateValueCache.begin(),
+        deterministicStateValueCache.end());
+    ProbabilisticSearchEngine::stateValueCache.insert(
+        probabilisticStateValueCache.begin(),
+        probabilisticStateValueCache.end());
+    IDS::rewardCache.insert(idsRewardCache.begin(), idsRewardCache.end());
+    MinimalLookaheadSearch::rewardCache.insert(
+        minimalLookaheadRewardCache.begin(), minimalLookaheadRewardCache.end());
+
+    cout << "Read learned data from " << learnedDataFile << " ("
+         << DeterministicSearchEngine::stateValueCache.size() << " + "
+         << ProbabilisticSearchEngine::stateValueCache.size() << " + "
+         << IDS::rewardCache.size() << " + "
+         << MinimalLookaheadSearch::rewardCache.size() << " cached entries)."
+         << endl;
+    return true;
+}
+
+void ProstPlanner::writeLearnedData() const {
+    // We write to a temporary file that replaces the old file only once it is
+    // complete, such that an interrupted run never leaves a truncated file
+    // behind (and concurrent runs never read a partially written one)
+    string tmpFile = learnedDataFile + ".tmp." + to_string(getpid());
+    ofstream out(tmpFile.c_str(), ios::binary | ios::trunc);
+    if (!out) {
+        cout << "Unable to write learned data to " << learnedDataFile << "."
+             << endl;
+        return;
+    }
+
+    out.write(learnedDataTag, sizeof(learnedDataTag));
+    writeValue(out, learnedDataVersion);
+    writeValue(out, SearchEngine::taskHash);
+    writeValue(out, searchEngineDesc);
+
+    ostringstream parameters;
+    searchEngine->writeLearnedParameters(parameters);
+    writeValue(out, parameters.str());
+    writeCache(out, DeterministicSearchEngine::stateValueCache);
+    writeCache(out, ProbabilisticSearchEngine::stateValueCache);
+    writeCache(out, IDS::rewardCache);
+    writeCache(out, MinimalLookaheadSearch::rewardCache);
+    out.close();
+
+    if (!out || (rename(tmpFile.c_str(), learnedDataFile.c_str()) != 0)) {
+        remove(tmpFile.c_str());
+        cout << "Unable to write learned data to " << learnedDataFile << "."
+             << endl;
+        return;
+    }
+    cout << "Wrote learned data to " << learnedDataFile << "." << endl;
 }
 
 void ProstPlanner::initRound(long const& remainingTime) {
@@ -175,9 +587,16 @@ void ProstPlanner::initRound(long const& remainingTime) {
          << ">>> STARTING ROUND " << (currentRound + 1) << " -- REMAINING TIME "
          << (remainingTime / 1000) << "s" << endl
          << "***********************************************" << endl;
+
+    searchEngine->initRound();
 }
 
 void ProstPlanner::finishRound(double const& roundReward) {
+    StatsRecord record("round");
+    record.add("round", currentRound + 1);
+    record.add("reward", roundReward);
+    StatsSink::write(record);
+
     cout << "***********************************************" << endl
          << ">>> END OF ROUND " << (currentRound + 1)
          << " -- REWARD RECEIVED: " << roundReward << endl
@@ -247,6 +666,7 @@ void ProstPlanner::manageTimeouts(long const& remainingTime) {
         remainingTimeInSeconds -= 3.0;
     }
     double timeForThisStep = 0.0;
+    double maxTimeForThisStep = 0.0;
 
     switch (tmMethod) {
     case NONE:
@@ -256,10 +676,45 @@ void ProstPlanner::manageTimeouts(long const& remainingTime) {
         timeForThisStep = remainingTimeInSeconds / remainingTimeFactor;
         --remainingTimeFactor;
         break;
+    case ADAPTIVE: {
+        // The remaining time is distributed among the remaining steps of the
+        // session according to their weight. Since the remaining time is
+        // measured by the server, time that is not used in a step is carried
+        // forward to the following steps.
+        double weightOfThisRound = 0.0;
+        double weightOfRound = 0.0;
+        for (int steps = 1; steps <= SearchEngine::horizon; ++steps) {
+            if (steps <= stepsToGo) {
+                weightOfThisRound += getStepWeight(steps);
+            }
+            weightOfRound += getStepWeight(steps);
+        }
+        double totalWeight = weightOfThisRound +
+                             (numberOfRounds - currentRound - 1) * weightOfRound;
+        if (MathUtils::doubleIsGreater(totalWeight, 0.0)) {
+            timeForThisStep = remainingTimeInSeconds *
+                              getStepWeight(stepsToGo) / totalWeight;
+        }
+        // The search may use up to three times as much if the decision is not
+        // clear, but never more than what is left
+        maxTimeForThisStep =
+            std::min(3.0 * timeForThisStep, remainingTimeInSeconds);
+        break;
     }
-    cout << "Setting time for this decision to " << timeForThisStep << "s."
-         << endl;
+    }
+    cout << "Setting time for this decision to " << timeForThisStep << "s";
+    if (tmMethod == ADAPTIVE) {
+        cout << " (at most " << maxTimeForThisStep << "s)";
+    }
+    cout << "." << endl;
     searchEngine->setTimeout(timeForThisStep);
+    searchEngine->setMaxTimeout(maxTimeForThisStep);
+}
+
+double ProstPlanner::getStepWeight(int steps) const {
+    // The decision in the last step is computed without search, and the
+    // trees of the steps before are small
+    return std::min(1.0, (steps - 1) / 4.0);
 }
 
 void ProstPlanner::finishStep(double const& immediateReward) {
@@ -268,6 +723,17 @@ void ProstPlanner::finishStep(double const& immediateReward) {
 
     immediateRewards[currentRound][currentStep] = immediateReward;
 
+    searchEngine->finishStep();
+
+    if (stepRecord) {
+        stepRecord->add("reward", immediateReward);
+        if (!bookAnswer) {
+            searchEngine->collectPonderingStats(*stepRecord);
+        }
+        StatsSink::write(*stepRecord);
+        stepRecord.reset();
+    }
+
     // searchEngine->print(cout);
 
     cout << endl << "Used RAM: " << SystemUtils::getRAMUsedByThis() << endl;
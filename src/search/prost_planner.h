@@ -5,12 +5,14 @@
 #include "states.h"
 
 #include <cassert>
+#include <memory>
+#include <unordered_map>
 
 class PlanningTask;
 
 class ProstPlanner {
 public:
-    enum TimeoutManagementMethod { NONE, UNIFORM };
+    enum TimeoutManagementMethod { NONE, UNIFORM, ADAPTIVE };
 
     ProstPlanner(std::string& plannerDesc);
 
@@ -34,6 +36,12 @@ public:
     // engine and return the next decision
     std::vector<std::string> plan();
 
+    // This is called while the environment computes the next state after the
+    // last decision has been submitted. It continues the search for at most a
+    // few milliseconds and returns false if the search engine cannot use more
+    // time (or if pondering is disabled).
+    bool ponder();
+
     // Parameter setters
     void setSearchEngine(SearchEngine* _searchEngine) {
         searchEngine = _searchEngine;
@@ -53,13 +61,52 @@ public:
         tmMethod = _tmMethod;
     }
 
+    void setLearnedDataFile(std::string _learnedDataFile) {
+        learnedDataFile = _learnedDataFile;
+    }
+
+    void setPonderingEnabled(bool _ponderingEnabled) {
+        ponderingEnabled = _ponderingEnabled;
+    }
+
+    void setBookTimePerState(double _bookTimePerState) {
+        bookTimePerState = _bookTimePerState;
+    }
+
+    void setBookDepth(int _bookDepth) {
+        bookDepth = _bookDepth;
+    }
+
 private:
     // Checks how much memory is used and aborts caching if necessary
     void monitorRAMUsage();
 
+    // Calls the search engine (and discards its output in quiet mode)
+    void estimateBestActions(State const& state, std::vector<int>& bestActions);
+
+    // Searches the initial state and the most likely states of the next
+    // bookDepth - 1 steps (if the best actions are applied) for
+    // bookTimePerState seconds each, and stores the best actions in the book
+    void createOpeningBook();
+
+    // Returns the state that is reached with the highest probability if the
+    // action is applied in the state
+    State getMostLikelySuccessor(State const& state, int actionIndex) const;
+
     // Assigns a timeout for the next decision
     void manageTimeouts(long const& remainingTime);
 
+    // The share of the remaining time that is assigned to a step with the
+    // given number of remaining steps under adaptive timeout management
+    double getStepWeight(int steps) const;
+
+    // Read learned parameters and cached values from a previous run on the
+    // same task with the same search engine (returns false if learnedDataFile
+    // does not exist or belongs to another task or search engine), and write
+    // them for the next run
+    bool readLearnedData();
+    void writeLearnedData() const;
+
     SearchEngine* searchEngine;
 
     State currentState;
@@ -78,9 +125,31 @@ private:
     int bitSize;
     int seed;
     TimeoutManagementMethod tmMethod;
+    std::string learnedDataFile;
+    bool ponderingEnabled;
+    double bookTimePerState;
+    int bookDepth;
+
+    // The description of the search engine (learned data is only reused if the
+    // search engine is identical)
+    std::string searchEngineDesc;
+
+    // The opening book contains the best actions of states that have been
+    // searched before the first round, and bookAnswer is true if the decision
+    // of the current step is taken from the book
+    typedef std::unordered_map<State, std::vector<int>, State::HashWithRemSteps,
+                               State::EqualWithRemSteps>
+        OpeningBook;
+    OpeningBook book;
+    bool bookAnswer;
+    int numberOfBookAnswers;
 
     std::vector<std::vector<double>> immediateRewards;
     std::vector<std::vector<int>> chosenActionIndices;
+
+    // The statistics of the current step (if they are written), which are
+    // collected when the action is chosen
+    std::unique_ptr<StatsRecord> stepRecord;
 };
 
 #endif
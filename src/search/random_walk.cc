@@ -46,21 +46,30 @@ void RandomWalk::performRandomWalks(PDState const& root, int firstActionIndex,
                                     double& result) const {
     result = 0.0;
     double reward = 0.0;
-    PDState next;
+
+    if (currentStates.size() != numberOfIterations) {
+        currentStates.resize(numberOfIterations);
+        nextStates.resize(numberOfIterations);
+    }
 
     for (unsigned int i = 0; i < numberOfIterations; ++i) {
-        PDState current(root.stepsToGo() - 1);
-        sampleSuccessorState(root, firstActionIndex, current, reward);
+        currentStates[i].reset(root.stepsToGo() - 1);
+        sampleSuccessorState(root, firstActionIndex, currentStates[i], reward);
         result += reward;
+    }
 
-        while (current.stepsToGo() > 0) {
-            int rndActionIndex = MathUtils::rnd->randomElement(
-                getIndicesOfApplicableActions(current));
-            next.reset(current.stepsToGo() - 1);
-            sampleSuccessorState(current, rndActionIndex, next, reward);
+    // All walks have the same number of remaining steps, so they are advanced
+    // together and the buffers of current and next states are swapped
+    // afterwards
+    for (int stepsToGo = root.stepsToGo() - 1; stepsToGo > 0; --stepsToGo) {
+        for (unsigned int i = 0; i < numberOfIterations; ++i) {
+            int rndActionIndex = sampleApplicableAction(currentStates[i]);
+            nextStates[i].reset(stepsToGo - 1);
+            sampleSuccessorState(currentStates[i], rndActionIndex,
+                                 nextStates[i], reward);
             result += reward;
-            current = next;
         }
+        currentStates.swap(nextStates);
     }
     result /= (double)numberOfIterations;
 }
@@ -74,4 +83,39 @@ void RandomWalk::sampleSuccessorState(PDState const& current,
          varIndex < State::numberOfProbabilisticStateFluents; ++varIndex) {
         next.sample(varIndex);
     }
+
+    // The hash keys are required for cached evaluations in the next step
+    State::calcStateFluentHashKeys(next);
+    State::calcStateHashKey(next);
+}
+
+int RandomWalk::sampleApplicableAction(State const& state) const {
+    // Applicable actions are usually cached, so we look them up directly to
+    // avoid the allocation of a new vector
+    ActionHashMap::const_iterator it = applicableActionsCache.find(state);
+    std::vector<int> applicableActions;
+    if (it == applicableActionsCache.end()) {
+        applicableActions = getApplicableActions(state);
+    }
+    std::vector<int> const& actions = (it == applicableActionsCache.end())
+                                          ? applicableActions
+                                          : it->second;
+
+    int numberOfApplicableActions = 0;
+    for (size_t index = 0; index < actions.size(); ++index) {
+        if (actions[index] == index) {
+            ++numberOfApplicableActions;
+        }
+    }
+    assert(numberOfApplicableActions > 0);
+
+    int selected =
+        MathUtils::rnd->genInt(0, numberOfApplicableActions - 1);
+    for (size_t index = 0; index < actions.size(); ++index) {
+        if ((actions[index] == index) && (selected-- == 0)) {
+            return index;
+        }
+    }
+    assert(false);
+    return -1;
 }
@@ -4,7 +4,9 @@
 #include "search_engine.h"
 
 // Evaluates all actions by simulating a run that starts with that action
-// followed by random actions until a terminal state is reached
+// followed by random actions until a terminal state is reached. All runs of an
+// evaluation are performed in lock step on preallocated state buffers, such
+// that no states have to be allocated or copied while walking.
 
 class RandomWalk : public ProbabilisticSearchEngine {
 public:
@@ -34,6 +36,15 @@ private:
     void sampleSuccessorState(PDState const& current, int const& actionIndex,
                               PDState& next, double& reward) const;
 
+    // Returns one of the applicable and reasonable actions in state uniformly
+    // at random
+    int sampleApplicableAction(State const& state) const;
+
+    // The states of all walks in the current and in the next step (these are
+    // only scratch buffers, so they are mutable)
+    mutable std::vector<PDState> currentStates;
+    mutable std::vector<PDState> nextStates;
+
     // Parameter
     int numberOfIterations;
 };
@@ -40,6 +40,8 @@ vector<long> KleeneState::hashKeyBases;
 vector<vector<pair<int, long>>> KleeneState::indexToStateFluentHashKeyMap;
 
 string SearchEngine::taskName;
+unsigned long long SearchEngine::taskHash = 0;
+bool SearchEngine::quiet = false;
 vector<State> SearchEngine::trainingSet;
 
 vector<ActionState> SearchEngine::actionStates;
@@ -263,6 +265,8 @@ bool ProbabilisticSearchEngine::isARewardLock(State const& current) const {
         return false;
     }
 
+    PhaseTimer timer(PhaseTimer::REWARD_LOCK_DETECTION);
+
     assert(goalTestActionIndex >= 0);
 
     // Calculate the reference reward
@@ -13,6 +13,9 @@
 
 #include "evaluatables.h"
 
+#include "utils/phase_timer.h"
+#include "utils/stats_sink.h"
+
 #include <fdd.h>
 
 class SearchEngine {
@@ -49,6 +52,21 @@ public:
         timeout = _timeout;
     }
 
+    // If the maximal timeout is larger than the timeout, the search engine
+    // may stop before the timeout if the decision is clear and may continue
+    // until the maximal timeout if it is not (only supported by THTS)
+    virtual void setMaxTimeout(double _maxTimeout) {
+        maxTimeout = _maxTimeout;
+    }
+
+    double const& getTimeout() const {
+        return timeout;
+    }
+
+    double const& getMaxTimeout() const {
+        return maxTimeout;
+    }
+
     virtual void setUseRewardLockDetection(bool _useRewardLockDetection) {
         useRewardLockDetection = _useRewardLockDetection;
     }
@@ -68,7 +86,8 @@ protected:
           useRewardLockDetection(SearchEngine::rewardLockDetected),
           cacheRewardLocks(true),
           maxSearchDepth(horizon),
-          timeout(1.0) {}
+          timeout(1.0),
+          maxTimeout(0.0) {}
 
     /*****************************************************************
                          Main search functions
@@ -77,6 +96,27 @@ public:
     // This is called initially to learn parameter values from a training set
     virtual void learn() {}
 
+    // This is called at the beginning of each round (before the first step,
+    // which is not necessarily searched, e.g. if it is answered from the
+    // opening book)
+    virtual void initRound() {}
+
+    // This is called after each step to allow search engines to adapt their
+    // parameters to the experience gathered in that step
+    virtual void finishStep() {}
+
+    // Writes the parameters that were determined in learn() to out, such that
+    // a later run can restore them with readLearnedParameters() instead of
+    // calling learn()
+    virtual void writeLearnedParameters(std::ostream& /*out*/) const {}
+
+    // Restores parameters that were written by writeLearnedParameters().
+    // Returns false if in does not contain valid parameters, in which case the
+    // search engine must not have been modified.
+    virtual bool readLearnedParameters(std::istream& /*in*/) {
+        return true;
+    }
+
     // Start the search engine to calculate best actions
     virtual void estimateBestActions(State const& _rootState,
                                      std::vector<int>& bestActions);
@@ -95,6 +135,14 @@ public:
                                  std::vector<int> const& actionsToExpand,
                                  std::vector<double>& qValues) = 0;
 
+    // This is called (repeatedly) after the action with index actionIndex has
+    // been submitted and while the next state is computed by the environment.
+    // The search engine may use up to the given time (in seconds) to prepare
+    // the next step. Returns false if it cannot use more time.
+    virtual bool ponder(int /*actionIndex*/, double const& /*time*/) {
+        return false;
+    }
+
     // Methods for action applicability and pruning
     virtual std::vector<int> getApplicableActions(State const& state) const = 0;
 
@@ -197,6 +245,10 @@ public:
     // The name of this task (this is equivalent to the instance name)
     static std::string taskName;
 
+    // Hash value of the content of the parser output (used to check if data
+    // that was persisted in a previous run belongs to this task)
+    static unsigned long long taskHash;
+
     // Random set of reachable states (these are used for learning)
     static std::vector<State> trainingSet;
 
@@ -276,6 +328,7 @@ protected:
     bool cacheRewardLocks;
     int maxSearchDepth;
     double timeout;
+    double maxTimeout;
 
     /*****************************************************************
                            Printing and statistics
@@ -289,6 +342,16 @@ public:
     virtual void printStats(std::ostream& out, bool const& printRoundStats,
                             std::string indent = "") const;
 
+    // Adds the statistics of the last step to a machine-readable record
+    virtual void collectStepStats(StatsRecord& /*record*/) const {}
+
+    // Adds the statistics of the pondering after the last step (which must
+    // not be part of the statistics of the search of that step)
+    virtual void collectPonderingStats(StatsRecord& /*record*/) const {}
+
+    // If this is true, no output is written during the search of a step
+    static bool quiet;
+
     static void printDeadEndBDD() {
         bdd_printdot(cachedDeadEnds);
     }
@@ -338,7 +401,11 @@ public:
     std::vector<int> getApplicableActions(State const& state) const {
         std::vector<int> res(numberOfActions, 0);
 
-        ActionHashMap::iterator it = applicableActionsCache.find(state);
+        ActionHashMap::iterator it;
+        {
+            PhaseTimer timer(PhaseTimer::CACHE_LOOKUP);
+            it = applicableActionsCache.find(state);
+        }
         if (it != applicableActionsCache.end()) {
             assert(it->second.size() == res.size());
             for (size_t i = 0; i < res.size(); ++i) {
@@ -393,6 +460,7 @@ protected:
     // Apply action 'actionIndex' to 'current', resulting in 'next'
     void calcSuccessorState(State const& current, int const& actionIndex,
                             PDState& next) const {
+        PhaseTimer timer(PhaseTimer::SUCCESSOR_COMPUTATION);
         for (int index = 0; index < State::numberOfDeterministicStateFluents;
              ++index) {
             deterministicCPFs[index]->evaluate(
@@ -481,6 +549,7 @@ protected:
     // in 'next'.
     void calcSuccessorState(State const& current, int const& actionIndex,
                             State& next) const {
+        PhaseTimer timer(PhaseTimer::SUCCESSOR_COMPUTATION);
         for (size_t index = 0; index < State::numberOfDeterministicStateFluents;
              ++index) {
             deterministicCPFs[index]->evaluate(
@@ -511,7 +580,11 @@ protected:
     std::vector<int> getApplicableActions(State const& state) const {
         std::vector<int> res(numberOfActions, 0);
 
-        ActionHashMap::iterator it = applicableActionsCache.find(state);
+        ActionHashMap::iterator it;
+        {
+            PhaseTimer timer(PhaseTimer::CACHE_LOOKUP);
+            it = applicableActionsCache.find(state);
+        }
         if (it != applicableActionsCache.end()) {
             assert(it->second.size() == res.size());
             for (size_t i = 0; i < res.size(); ++i) {
@@ -203,6 +203,11 @@ public:
         return stateFluentHashKeys[index];
     }
 
+    // Only meaningful if stateHashingPossible is true
+    long const& getHashKey() const {
+        return hashKey;
+    }
+
     struct CompareIgnoringStepsToGo {
         bool operator()(State const& lhs, State const& rhs) const {
             if ((lhs.hashKey >= 0) && (rhs.hashKey >= 0)) {
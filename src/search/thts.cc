@@ -6,8 +6,14 @@
 #include "outcome_selection.h"
 #include "recommendation_function.h"
 
+#include "utils/phase_timer.h"
 #include "utils/system_utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
 std::vector<double> SearchNode::qvalueMean;
 
 /******************************************************************
@@ -30,17 +36,51 @@ THTS::THTS(std::string _name)
           appliedActionIndex(-1),
           trialReward(0.0),
           currentTrial(0),
+          tailSolverDepth(2),
+          tailSolverAborted(false),
+          numberOfTailExpansions(0),
+          numberOfTailSuccessors(0),
+          numberOfSolvedTails(0),
+          numberOfTranspositions(0),
+          numberOfMemoizedTransitions(0),
           initializedDecisionNodes(0),
           lastUsedNodePoolIndex(0),
           terminationMethod(THTS::TIME),
           maxNumberOfTrials(0),
           numberOfNewDecisionNodesPerTrial(1),
+          stabilityWindow(0),
+          confidenceFactor(0.0),
+          keptTreeBudget(0),
+          maxNumberOfMemoizedTransitions(0),
+          useJointOutcomes(false),
+          useTranspositions(false),
+          tailSolverTimeout(0.0),
+          recycleFraction(0.0),
+          numberOfStepsWithKeptTrees(1),
           numberOfRuns(0),
           cacheHits(0),
           accumulatedNumberOfStepsToGoInFirstSolvedRootState(0),
           firstSolvedFound(false),
           accumulatedNumberOfTrialsInRootState(0),
           accumulatedNumberOfSearchNodesInRootState(0),
+          ponderedActionIndex(-1),
+          searchDepthIsLimited(false),
+          numberOfPonderingTrials(0),
+          numberOfPonderingNodes(0),
+          numberOfReusedNodes(0),
+          numberOfRecycledNodes(0),
+          numberOfRecyclings(0),
+          numberOfKeptNodes(0),
+          rootStateIsKept(false),
+          keptRootStateVisits(0),
+          numberOfRestoredNodes(0),
+          bestRootActionIndex(-1),
+          bestRootActionTrial(0),
+          bestRootQValue(0.0),
+          secondBestRootActionIndex(-1),
+          secondBestRootQValue(0.0),
+          stoppedEarly(false),
+          numberOfEarlyTerminations(0),
           timestep(0.01),
           lasttime(0.0) {
     setMaxNumberOfNodes(24000000);
@@ -94,6 +134,33 @@ bool THTS::setValueFromString(std::string &param, std::string &value) {
             setNumberOfNewDecisionNodesPerTrial(atoi(value.c_str()));
         }
         return true;
+    } else if (param == "-stab") {
+        setStabilityWindow(atoi(value.c_str()));
+        return true;
+    } else if (param == "-conf") {
+        setConfidenceFactor(atof(value.c_str()));
+        return true;
+    } else if (param == "-recycle") {
+        setRecycleFraction(atof(value.c_str()));
+        return true;
+    } else if (param == "-tst") {
+        setTailSolverTimeout(atof(value.c_str()));
+        return true;
+    } else if (param == "-tt") {
+        setUseTranspositions(atoi(value.c_str()));
+        return true;
+    } else if (param == "-jo") {
+        setUseJointOutcomes(atoi(value.c_str()));
+        return true;
+    } else if (param == "-mt") {
+        setMaxNumberOfMemoizedTransitions(atoi(value.c_str()));
+        return true;
+    } else if (param == "-kt") {
+        setKeptTreeBudget(atoi(value.c_str()));
+        return true;
+    } else if (param == "-kts") {
+        setNumberOfStepsWithKeptTrees(atoi(value.c_str()));
+        return true;
     } else if (param == "-node-limit") {
         setMaxNumberOfNodes(atoi(value.c_str()));
         return true;
@@ -105,6 +172,16 @@ bool THTS::setValueFromString(std::string &param, std::string &value) {
     return SearchEngine::setValueFromString(param, value);
 }
 
+void THTS::setUseJointOutcomes(bool _useJointOutcomes) {
+    // Joint outcomes are identified by the hash key of the successor state
+    if (_useJointOutcomes && !State::stateHashingPossible) {
+        std::cout << "Joint outcomes are not used since state hashing is not "
+                     "possible." << std::endl;
+        _useJointOutcomes = false;
+    }
+    useJointOutcomes = _useJointOutcomes;
+}
+
 void THTS::setActionSelection(ActionSelection *_actionSelection) {
     if (actionSelection) {
         delete actionSelection;
@@ -173,11 +250,24 @@ void THTS::learn() {
     std::cout << name << ": ...finished" << std::endl;
 }
 
+void THTS::finishStep() {
+    initializer->finishStep();
+}
+
+void THTS::writeLearnedParameters(std::ostream &out) const {
+    initializer->writeLearnedParameters(out);
+}
+
+bool THTS::readLearnedParameters(std::istream &in) {
+    return initializer->readLearnedParameters(in);
+}
+
 /******************************************************************
                  Initialization of search phases
 ******************************************************************/
 
 void THTS::initRound() {
+    ponderedActionIndex = -1;
     //std::cout << name << "t init round"<<std::endl;
     //pq.clear();
     stopwatchRuntime.reset();
@@ -191,10 +281,24 @@ void THTS::initRound() {
 }
 
 void THTS::initStep(State const &_rootState) {
+    // The tree of the last step can only be reused if it has been extended by
+    // pondering (this must be checked before the states are overwritten)
+    SearchNode* nextRootNode = nullptr;
+    if (rootStateIsKept) {
+        // There is no pondering if the tree is kept (see ponder)
+        assert(ponderedActionIndex < 0);
+        keepCurrentTree();
+        rootStateIsKept = false;
+    } else if (ponderedActionIndex >= 0) {
+        nextRootNode = getPonderedSuccessor(_rootState);
+        ponderedActionIndex = -1;
+    }
+
     pq.clear(); //
     PDState rootState(_rootState);
     // Adjust maximal search depth and set root state
-    if (rootState.stepsToGo() > maxSearchDepth) {
+    searchDepthIsLimited = (rootState.stepsToGo() > maxSearchDepth);
+    if (searchDepthIsLimited) {
         maxSearchDepthForThisStep = maxSearchDepth;
         states[maxSearchDepthForThisStep].setTo(rootState);
         states[maxSearchDepthForThisStep].stepsToGo() =
@@ -212,10 +316,51 @@ void THTS::initStep(State const &_rootState) {
 
     // Reset step dependent counter
     currentTrial = 0;
+    bestRootActionIndex = -1;
+    bestRootActionTrial = 0;
+    secondBestRootActionIndex = -1;
+    stoppedEarly = false;
     cacheHits = 0;
-
-    // Reset search nodes and create root node
-    currentRootNode = createRootNode();
+    numberOfMemoizedTransitions = 0;
+    numberOfRecycledNodes = 0;
+    numberOfRecyclings = 0;
+    numberOfTranspositions = 0;
+    numberOfSolvedTails = 0;
+    tailValues.clear();
+    numberOfEQclasses = 0;
+    searchTime = 0.0;
+    abstractionTime = 0.0;
+
+    // Reset search nodes and create root node (or reuse the pondered subtree
+    // or a tree that has been kept from an earlier round). Trees with joint
+    // outcomes are not reused since the map of joint outcomes is rebuilt in
+    // each step.
+    numberOfRestoredNodes = 0;
+    jointOutcomes.clear();
+    transpositions.clear();
+    if ((keptTreeBudget > 0) && !searchDepthIsLimited && !useJointOutcomes &&
+        (rootState.stepsToGo() >
+         SearchEngine::horizon - numberOfStepsWithKeptTrees)) {
+        rootStateIsKept = true;
+        keptRootState = _rootState;
+        keptRootStateVisits = 1;
+    }
+    KeptTreeMap::iterator it = keptTrees.end();
+    if (rootStateIsKept) {
+        it = keptTrees.find(_rootState);
+    }
+    if (it != keptTrees.end()) {
+        keptRootStateVisits += it->second.numberOfVisits;
+        restoreKeptTree(it->second);
+        keptTrees.erase(it);
+        numberOfReusedNodes = 0;
+    } else if (nextRootNode && !nextRootNode->children.empty() &&
+               (nextRootNode->stepsToGo == maxSearchDepthForThisStep)) {
+        reuseSubtree(nextRootNode);
+    } else {
+        currentRootNode = createRootNode();
+        numberOfReusedNodes = 0;
+    }
 
     std::cout << name << ": Maximal search depth set to "
               << maxSearchDepthForThisStep << std::endl
@@ -257,17 +402,15 @@ void THTS::estimateBestActions(State const &_rootState,
     stopwatch.reset();
     stopwatch2.reset();
     stopwatch2.saveTime();
+    PhaseTimer::initStep();
 
 
-    std::cout << "reset of the stopwatch "  << std::endl;
-
-    // Init round (if this is the first call in a round)
-    if (_rootState.stepsToGo() == SearchEngine::horizon) {
-        initRound();
+    if (!quiet) {
+        std::cout << "reset of the stopwatch "  << std::endl;
     }
 
     // Init step (this function is currently only called once per step) TODO:
-    // maybe we should call initRound, initStep and printStats from "outside"
+    // maybe we should call initStep and printStats from "outside"
     // such that we can also use this as a heuristic without generating too much
     // output
     initStep(_rootState);
@@ -282,6 +425,7 @@ void THTS::estimateBestActions(State const &_rootState,
         std::cout << std::endl << std::endl;
         bestActions.push_back(uniquePolicyOpIndex);
         currentRootNode = nullptr;
+        searchTime = stopwatch();
         printStats(std::cout, (_rootState.stepsToGo() == 1));
         return;
     }
@@ -349,9 +493,16 @@ void THTS::estimateBestActions(State const &_rootState,
 
             stopwatch.saveTime();
             stopwatch2.continueTime();
-            std::cout << " startEQ "  <<std::endl;
-            generateEquivalenceClass();
-            std::cout << "endEQ "  << std::endl;
+            if (!quiet) {
+                std::cout << " startEQ "  <<std::endl;
+            }
+            {
+                PhaseTimer timer(PhaseTimer::ABSTRACTION);
+                generateEquivalenceClass();
+            }
+            if (!quiet) {
+                std::cout << "endEQ "  << std::endl;
+            }
           //  std::cout<<"on level "<<currentTrial<<std::endl;
             stopwatch.continueTime();
            lasttimepoint=std::chrono::steady_clock::now();
@@ -360,7 +511,9 @@ void THTS::estimateBestActions(State const &_rootState,
 
             // time_interval+=t();
            // std::cout << "lasttime" << lasttime << " / " << std::endl;
-            std::cout << "end stopwatch:  " << stopwatch  << std::endl;
+            if (!quiet) {
+                std::cout << "end stopwatch:  " << stopwatch  << std::endl;
+            }
 
             // time2=std::chrono::steady_clock::now();
 
@@ -393,14 +546,413 @@ void THTS::estimateBestActions(State const &_rootState,
 
     // Print statistics
    // assert(stopwatch()>0.1);
-    std::cout << "Search time: " << stopwatch << std::endl;
-    std::cout << "generating abstraction: " << stopwatch2 << std::endl;
+    searchTime = stopwatch();
+    abstractionTime = stopwatch2.savedTime();
+    std::cout << "Search time: " << searchTime << "s" << std::endl;
+    std::cout << "generating abstraction: " << abstractionTime << "s"
+              << std::endl;
     std::cout << "All time " << stopwatchRuntime<< std::endl;
     printStats(std::cout, (_rootState.stepsToGo() == 1));
 }
 
+bool THTS::timeoutReached() {
+    if (!MathUtils::doubleIsGreater(maxTimeout, timeout)) {
+        return MathUtils::doubleIsGreater(stopwatch(), timeout);
+    }
+    // The time that is used to generate the abstraction grows quickly with
+    // the size of the tree, so it must be included if the search continues
+    // beyond the timeout
+    double time = stopwatch() + stopwatch2.savedTime();
+
+    if (MathUtils::doubleIsGreater(time, maxTimeout)) {
+        return true;
+    } else if (MathUtils::doubleIsSmaller(time, 0.5 * timeout)) {
+        return false;
+    }
+
+    // The decision is stable if the best action has not changed in the second
+    // half of the trials (and there are enough trials to tell), and it is
+    // close if the Q-values of the best two actions differ by less than 1%
+    bool isStable =
+        (currentTrial >= 100) && (2 * bestRootActionTrial <= currentTrial);
+    bool isClose = (secondBestRootActionIndex >= 0) &&
+                   MathUtils::doubleIsSmaller(bestRootQValue -
+                                                  secondBestRootQValue,
+                                              0.01 * std::abs(bestRootQValue));
+    if (MathUtils::doubleIsGreater(time, timeout)) {
+        return isStable && !isClose;
+    }
+    return isStable && !isClose && (secondBestRootActionIndex >= 0);
+}
+
+void THTS::updateBestRootActions() {
+    int bestActionIndex = -1;
+    secondBestRootActionIndex = -1;
+    for (unsigned int i = 0; i < currentRootNode->children.size(); ++i) {
+        SearchNode *child = currentRootNode->children[i];
+        if (!child) {
+            continue;
+        }
+        double qValue = child->getExpectedConcreteRewardEstimate();
+        if ((bestActionIndex < 0) ||
+            MathUtils::doubleIsGreater(qValue, bestRootQValue)) {
+            secondBestRootActionIndex = bestActionIndex;
+            secondBestRootQValue = bestRootQValue;
+            bestActionIndex = i;
+            bestRootQValue = qValue;
+        } else if ((secondBestRootActionIndex < 0) ||
+                   MathUtils::doubleIsGreater(qValue, secondBestRootQValue)) {
+            secondBestRootActionIndex = i;
+            secondBestRootQValue = qValue;
+        }
+    }
+    if (bestActionIndex != bestRootActionIndex) {
+        bestRootActionIndex = bestActionIndex;
+        bestRootActionTrial = currentTrial;
+    }
+}
+
+bool THTS::earlyTerminationReached() const {
+    // There is nothing to decide if there is only one reasonable action
+    if (secondBestRootActionIndex < 0) {
+        return false;
+    }
+
+    if ((stabilityWindow > 0) &&
+        (currentTrial - bestRootActionTrial >= stabilityWindow)) {
+        return true;
+    }
+
+    if (MathUtils::doubleIsGreater(confidenceFactor, 0.0)) {
+        // Like the exploration term of UCB1, the width of the intervals is
+        // scaled with the magnitude of the Q-values since rewards are not
+        // normalized
+        SearchNode *best = currentRootNode->children[bestRootActionIndex];
+        SearchNode *secondBest =
+            currentRootNode->children[secondBestRootActionIndex];
+        if ((best->numberOfVisits == 0) || (secondBest->numberOfVisits == 0)) {
+            return false;
+        }
+        double scale = confidenceFactor *
+                       std::max(std::abs(bestRootQValue),
+                                std::abs(secondBestRootQValue));
+        double bestLowerBound =
+            bestRootQValue - scale / std::sqrt((double)best->numberOfVisits);
+        double secondBestUpperBound =
+            secondBestRootQValue +
+            scale / std::sqrt((double)secondBest->numberOfVisits);
+        return MathUtils::doubleIsGreater(bestLowerBound, secondBestUpperBound);
+    }
+    return false;
+}
+
+bool THTS::ponder(int actionIndex, double const &time) {
+    // Pondering is pointless if the successors of the root node are leaves,
+    // and the tree cannot be reused if the search depth is limited, if it is
+    // kept for later rounds or if it has joint outcomes
+    if (!currentRootNode || searchDepthIsLimited || rootStateIsKept ||
+        useJointOutcomes || (maxSearchDepthForThisStep <= 2)) {
+        return false;
+    }
+    SearchNode *actionNode = currentRootNode->children[actionIndex];
+    if (!actionNode) {
+        return false;
+    }
+
+    if (ponderedActionIndex != actionIndex) {
+        ponderedActionIndex = actionIndex;
+        numberOfPonderingTrials = 0;
+        numberOfPonderingNodes = 0;
+    }
+
+    // Outcome selection samples the outcomes of the submitted action according
+    // to their probability, so the most probable next states are searched most
+    Stopwatch ponderingTime;
+    int firstNewNodeIndex = lastUsedNodePoolIndex;
+    bool timeIsUp = false;
+    while (!actionNode->solved &&
+           (lastUsedNodePoolIndex < maxNumberOfNodes)) {
+        visitDecisionNode(currentRootNode);
+        ++numberOfPonderingTrials;
+        if (MathUtils::doubleIsGreater(ponderingTime(), time)) {
+            timeIsUp = true;
+            break;
+        }
+    }
+    numberOfPonderingNodes += lastUsedNodePoolIndex - firstNewNodeIndex;
+    return timeIsUp;
+}
+
+SearchNode *THTS::getPonderedSuccessor(State const &nextState) {
+    assert(currentRootNode && (ponderedActionIndex >= 0));
+    SearchNode *node = currentRootNode->children[ponderedActionIndex];
+    assert(node);
+
+    // Compute the distributions of the successors of the last root state to
+    // navigate through the chance node layers like the outcome selection
+    PDState &successor = states[maxSearchDepthForThisStep - 1];
+    successor.reset(maxSearchDepthForThisStep - 1);
+    calcSuccessorState(states[maxSearchDepthForThisStep], ponderedActionIndex,
+                       successor);
+
+    bool isDeterministic = true;
+    for (unsigned int i = 0; i < State::numberOfProbabilisticStateFluents;
+         ++i) {
+        if (successor.probabilisticStateFluentAsPD(i).isDeterministic()) {
+            continue;
+        }
+        isDeterministic = false;
+        int childIndex = static_cast<int>(nextState.probabilisticStateFluent(i));
+        if (childIndex >= node->children.size() ||
+            !node->children[childIndex]) {
+            return nullptr;
+        }
+        node = node->children[childIndex];
+    }
+
+    if (isDeterministic) {
+        // See visitDummyChanceNode
+        if (node->children.empty()) {
+            return nullptr;
+        }
+        node = node->children[0];
+    }
+    assert(!node->isChanceNode);
+    return node;
+}
+
+void THTS::reuseSubtree(SearchNode *node) {
+    compactNodePool(node);
+
+    node->prob = 1.0;
+    node->immediateReward = 0.0;
+    currentRootNode = node;
+    numberOfReusedNodes = lastUsedNodePoolIndex;
+}
+
+std::vector<SearchNode *> THTS::compactNodePool(SearchNode *node) {
+    // Collect the nodes of the subtree (nodes that are shared by
+    // transpositions are only collected once)
+    std::vector<SearchNode *> subtree(1, node);
+    std::unordered_set<SearchNode *> reached;
+    for (size_t i = 0; i < subtree.size(); ++i) {
+        for (SearchNode *child : subtree[i]->children) {
+            if (child && (!useTranspositions || reached.insert(child).second)) {
+                subtree.push_back(child);
+            }
+        }
+    }
+
+    // Move them to the front of the node pool and release all other nodes
+    std::sort(subtree.begin(), subtree.end());
+    std::partition(nodePool.begin(), nodePool.begin() + lastUsedNodePoolIndex,
+                   [&subtree](SearchNode *poolNode) {
+                       return std::binary_search(subtree.begin(),
+                                                 subtree.end(), poolNode);
+                   });
+    lastUsedNodePoolIndex = subtree.size();
+
+    initAbstractionOfReusedTree();
+    return subtree;
+}
+
+void THTS::recycleNodes() {
+    // Collect the nodes of the tree together with the smallest key of the
+    // action nodes on the path from the root, where the key of an action node
+    // is -1 if it is solved and its number of visits otherwise. Since a node
+    // is never visited more often than its parent, the subtrees below the
+    // action nodes with the smallest keys are the least visited ones
+    // (with transpositions, a shared node gets the key of the first path on
+    // which it is reached).
+    std::vector<SearchNode *> nodes(1, currentRootNode);
+    std::vector<int> keys(1, std::numeric_limits<int>::max());
+    std::unordered_set<SearchNode *> reached;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        SearchNode *node = nodes[i];
+        int key = keys[i];
+        if (node->isActionNode) {
+            key = std::min(key, node->solved ? -1 : node->numberOfVisits);
+        }
+        for (SearchNode *child : node->children) {
+            if (child && (!useTranspositions || reached.insert(child).second)) {
+                nodes.push_back(child);
+                keys.push_back(key);
+            }
+        }
+    }
+
+    // Determine the largest key such that enough nodes are released if the
+    // subtrees below the action nodes with at most that key are pruned
+    size_t numberOfNodesToRelease = std::min(
+        nodes.size() - 1,
+        static_cast<size_t>(recycleFraction * maxNumberOfNodes) + 1);
+    std::vector<int> sortedKeys(keys);
+    std::nth_element(sortedKeys.begin(),
+                     sortedKeys.begin() + numberOfNodesToRelease - 1,
+                     sortedKeys.end());
+    int maxKey = sortedKeys[numberOfNodesToRelease - 1];
+    if (maxKey == std::numeric_limits<int>::max()) {
+        return;
+    }
+
+    // The pruned action nodes keep their value estimates and are expanded
+    // again when they are visited (incremental backups start from scratch
+    // with the new children)
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        SearchNode *node = nodes[i];
+        if (node->isActionNode && !node->children.empty() &&
+            (keys[i] > maxKey) &&
+            ((node->solved ? -1 : node->numberOfVisits) <= maxKey)) {
+            std::vector<SearchNode *> tmp;
+            node->children.swap(tmp);
+            node->childWeightSum = 0.0;
+        }
+    }
+
+    pq.clear();
+    int numberOfNodes = lastUsedNodePoolIndex;
+    std::vector<SearchNode *> sortedTree = compactNodePool(currentRootNode);
+    numberOfRecycledNodes += numberOfNodes - lastUsedNodePoolIndex;
+    ++numberOfRecyclings;
+
+    // Remove the joint outcomes and transpositions whose decision node has
+    // been released
+    for (JointOutcomeMap::iterator it = jointOutcomes.begin();
+         it != jointOutcomes.end();) {
+        if (std::binary_search(sortedTree.begin(), sortedTree.end(),
+                               it->second)) {
+            ++it;
+        } else {
+            it = jointOutcomes.erase(it);
+        }
+    }
+    for (TranspositionTable::iterator it = transpositions.begin();
+         it != transpositions.end();) {
+        if (std::binary_search(sortedTree.begin(), sortedTree.end(),
+                               it->second)) {
+            ++it;
+        } else {
+            it = transpositions.erase(it);
+        }
+    }
+}
+
+void THTS::initAbstractionOfReusedTree() {
+    // Equivalence classes are generated from scratch, so all decision nodes and
+    // initialized action nodes are inserted into the multiset as they would
+    // have been if they were created in this step
+    for (unsigned int i = 0; i < lastUsedNodePoolIndex; ++i) {
+        SearchNode *node = nodePool[i];
+        node->equivalenceClassPos = -1;
+        // Memoized transitions are only valid in the step they are created in
+        node->transitionIndex = -1;
+        if (!node->isChanceNode || (node->isActionNode && node->initialized)) {
+            pq.insert(node);
+        }
+    }
+}
+
+void THTS::keepCurrentTree() {
+    int treeSize = lastUsedNodePoolIndex;
+    if (treeSize > keptTreeBudget) {
+        return;
+    }
+
+    // Discard the smallest trees of states that are not visited more often
+    // until the tree fits into the budget
+    while (numberOfKeptNodes + treeSize > keptTreeBudget) {
+        KeptTreeMap::iterator discarded = keptTrees.end();
+        for (KeptTreeMap::iterator it = keptTrees.begin();
+             it != keptTrees.end(); ++it) {
+            if ((it->second.numberOfVisits <= keptRootStateVisits) &&
+                ((discarded == keptTrees.end()) ||
+                 (it->second.nodes.size() < discarded->second.nodes.size()))) {
+                discarded = it;
+            }
+        }
+        if (discarded == keptTrees.end()) {
+            return;
+        }
+        discardKeptTree(discarded->second);
+        keptTrees.erase(discarded);
+    }
+
+    // The nodes of the tree are moved behind the other allocated nodes of the
+    // pool, so the allocated nodes remain a contiguous block at its front
+    unsigned int numberOfAllocatedNodes = lastUsedNodePoolIndex;
+    while ((numberOfAllocatedNodes < nodePool.size()) &&
+           nodePool[numberOfAllocatedNodes]) {
+        ++numberOfAllocatedNodes;
+    }
+    std::rotate(nodePool.begin(), nodePool.begin() + treeSize,
+                nodePool.begin() + numberOfAllocatedNodes);
+
+    KeptTree &tree = keptTrees[keptRootState];
+    tree.root = currentRootNode;
+    tree.nodes.assign(nodePool.begin() + numberOfAllocatedNodes - treeSize,
+                      nodePool.begin() + numberOfAllocatedNodes);
+    tree.numberOfVisits = keptRootStateVisits;
+    std::fill(nodePool.begin() + numberOfAllocatedNodes - treeSize,
+              nodePool.begin() + numberOfAllocatedNodes, nullptr);
+    numberOfKeptNodes += treeSize;
+
+    lastUsedNodePoolIndex = 0;
+    currentRootNode = nullptr;
+}
+
+void THTS::restoreKeptTree(KeptTree &tree) {
+    unsigned int treeSize = tree.nodes.size();
+    unsigned int numberOfAllocatedNodes = 0;
+    while ((numberOfAllocatedNodes < nodePool.size()) &&
+           nodePool[numberOfAllocatedNodes]) {
+        ++numberOfAllocatedNodes;
+    }
+
+    // Release allocated nodes if there is not enough space in the pool
+    if (numberOfAllocatedNodes + treeSize > nodePool.size()) {
+        growNodePool(numberOfAllocatedNodes + treeSize);
+    }
+    while (numberOfAllocatedNodes + treeSize > nodePool.size()) {
+        --numberOfAllocatedNodes;
+        nodePool[numberOfAllocatedNodes]->children.clear();
+        delete nodePool[numberOfAllocatedNodes];
+        nodePool[numberOfAllocatedNodes] = nullptr;
+    }
+
+    // Insert the nodes of the tree at the front of the pool (all other
+    // allocated nodes are released)
+    std::copy(tree.nodes.begin(), tree.nodes.end(),
+              nodePool.begin() + numberOfAllocatedNodes);
+    std::rotate(nodePool.begin(), nodePool.begin() + numberOfAllocatedNodes,
+                nodePool.begin() + numberOfAllocatedNodes + treeSize);
+    lastUsedNodePoolIndex = treeSize;
+    numberOfKeptNodes -= treeSize;
+
+    initAbstractionOfReusedTree();
+
+    currentRootNode = tree.root;
+    numberOfRestoredNodes = treeSize;
+}
+
+void THTS::discardKeptTree(KeptTree &tree) {
+    // The children are cleared first since the destructor of SearchNode
+    // deletes them recursively
+    for (SearchNode *node : tree.nodes) {
+        node->children.clear();
+    }
+    for (SearchNode *node : tree.nodes) {
+        delete node;
+    }
+    numberOfKeptNodes -= tree.nodes.size();
+}
+
 bool THTS::moreTrials() {
-    // Check memory constraints and solvedness
+    // Check memory constraints and solvedness (if the memory is bounded, the
+    // least visited subtrees are released instead)
+    if (MathUtils::doubleIsGreater(recycleFraction, 0.0) &&
+        (lastUsedNodePoolIndex >= maxNumberOfNodes)) {
+        recycleNodes();
+    }
     if (currentRootNode->solved ||
         (lastUsedNodePoolIndex >= maxNumberOfNodes)) {
         return false;
@@ -410,10 +962,27 @@ bool THTS::moreTrials() {
         return true;
     }
 
+    bool isAdaptive = (terminationMethod != THTS::NUMBER_OF_TRIALS) &&
+                      MathUtils::doubleIsGreater(maxTimeout, timeout);
+    bool isEarlyTerminationEnabled =
+        (stabilityWindow > 0) ||
+        MathUtils::doubleIsGreater(confidenceFactor, 0.0);
+    if (isAdaptive || isEarlyTerminationEnabled) {
+        updateBestRootActions();
+    }
+    if (isEarlyTerminationEnabled && earlyTerminationReached()) {
+        // The remaining time of this step is available for later steps
+        // since the time manager of the planner distributes the time that is
+        // actually left
+        stoppedEarly = true;
+        ++numberOfEarlyTerminations;
+        return false;
+    }
+
     // Check selected termination criterion
     switch (terminationMethod) {
         case THTS::TIME:
-            if (MathUtils::doubleIsGreater(stopwatch(), timeout)) {
+            if (timeoutReached()) {
                 return false;
             }
             break;
@@ -423,8 +992,7 @@ bool THTS::moreTrials() {
             }
             break;
         case THTS::TIME_AND_NUMBER_OF_TRIALS:
-            if (MathUtils::doubleIsGreater(stopwatch(), timeout) ||
-                (currentTrial == maxNumberOfTrials)) {
+            if (timeoutReached() || (currentTrial == maxNumberOfTrials)) {
                 return false;
             }
             break;
@@ -452,6 +1020,21 @@ void THTS::visitDecisionNode(SearchNode *node) {
             //      std::cout << "t special case  " <<std::endl;
             pq.insert(node);
             return;
+        } else if (useTranspositions && transpositionIsSolved(node)) {
+            if (!tipNodeOfTrial) {
+                tipNodeOfTrial = node;
+            }
+            return;
+        } else if (node->solved) {
+            // Joint outcome selection returns a solved node if it samples no
+            // unsolved one, which is usually stopped by the cache lookup but
+            // not if caching is disabled
+            if (!tipNodeOfTrial) {
+                tipNodeOfTrial = node;
+            }
+            trialReward = node->futureReward;
+            backupDecisionNodeLeaf(node);
+            return;
         }
     }
     //  std::cout << "t nothing special " <<std::endl;
@@ -461,7 +1044,10 @@ void THTS::visitDecisionNode(SearchNode *node) {
             tipNodeOfTrial = node;
         }
 
-        initializer->initialize(node, states[stepsToGoInCurrentState]);
+        PhaseTimer timer(PhaseTimer::INITIALIZATION);
+        if (!useTranspositions || !shareTransposition(node)) {
+            initializer->initialize(node, states[stepsToGoInCurrentState]);
+        }
         //add node+children  to the multiset
      /*   pq.insert(node);
         //  std::cout << "parent level: "<<node->stepsToGo << " is a ChanceNode  " <<node->isChanceNode << "        and isleaf  " <<node->isALeafNode()<<std::endl;
@@ -491,7 +1077,14 @@ void THTS::visitDecisionNode(SearchNode *node) {
     if (continueTrial(node)) {
         //    std::cout << "t in continue trial " <<std::endl;
         // Select the action that is simulated
-        appliedActionIndex = actionSelection->selectAction(node);
+        {
+            PhaseTimer timer(PhaseTimer::ACTION_SELECTION);
+            if ((node == currentRootNode) && (ponderedActionIndex >= 0)) {
+                appliedActionIndex = ponderedActionIndex;
+            } else {
+                appliedActionIndex = actionSelection->selectAction(node);
+            }
+        }
         //   std::cout << "t after  selectAction " <<std::endl;
         assert(node->children[appliedActionIndex]);
         assert(!node->children[appliedActionIndex]->solved);
@@ -501,43 +1094,31 @@ void THTS::visitDecisionNode(SearchNode *node) {
         // std::cout << std::endl;
 
         // Sample successor state
-        //std::cout << "t before calc " <<std::endl;
-        calcSuccessorState(states[stepsToGoInCurrentState], appliedActionIndex,
-                           states[stepsToGoInNextState]);
-        //std::cout << "t after calc " <<std::endl;
+        VisitedChild visited(node->children[appliedActionIndex], false);
+        calcSuccessorDistribution(node->children[appliedActionIndex]);
 
         // std::cout << "Sampled PDState is " << std::endl;
         // states[stepsToGoInNextState].printPDStateCompact(std::cout);
         // std::cout << std::endl;
 
-        lastProbabilisticVarIndex = -1;
-        for (unsigned int i = 0; i < State::numberOfProbabilisticStateFluents;
-             ++i) {
-            if (states[stepsToGoInNextState]
-                    .probabilisticStateFluentAsPD(i)
-                    .isDeterministic()) {
-                states[stepsToGoInNextState].probabilisticStateFluent(i) =
-                        states[stepsToGoInNextState]
-                                .probabilisticStateFluentAsPD(i)
-                                .values[0];
-            } else {
-                lastProbabilisticVarIndex = i;
-            }
-        }
-
         // Start outcome selection with the first probabilistic variable
         chanceNodeVarIndex = 0;
         // std::cout << "t before visitng NODES " <<std::endl;
         // Continue trial with chance nodes
         if (lastProbabilisticVarIndex < 0) {
             visitDummyChanceNode(node->children[appliedActionIndex]);
+        } else if (useJointOutcomes) {
+            visitJointChanceNode(node->children[appliedActionIndex]);
         } else {
             visitChanceNode(node->children[appliedActionIndex]);
         }
 
         // std::cout << "t before backup " <<std::endl;
         // Backup this node
-        backupFunction->backupDecisionNode(node);
+        {
+            PhaseTimer timer(PhaseTimer::BACKUP);
+            backupFunction->backupDecisionNode(node, visited);
+        }
         trialReward += node->immediateReward;
 
         // std::cout << "t after backup " <<std::endl;
@@ -568,18 +1149,22 @@ bool THTS::currentStateIsSolved(SearchNode *node) {
         // is taken care of by calcOptimalFinalReward)
 
         calcOptimalFinalReward(states[1], trialReward);
-        backupFunction->backupDecisionNodeLeaf(node, trialReward);
-        trialReward += node->immediateReward;
+        backupDecisionNodeLeaf(node);
 
         return true;
-    } else if (ProbabilisticSearchEngine::stateValueCache.find(
-            states[stepsToGoInCurrentState]) !=
-               ProbabilisticSearchEngine::stateValueCache.end()) {
+    }
+
+    StateValueHashMap::iterator it;
+    {
+        PhaseTimer timer(PhaseTimer::CACHE_LOOKUP);
+        it = ProbabilisticSearchEngine::stateValueCache.find(
+                states[stepsToGoInCurrentState]);
+    }
+
+    if (it != ProbabilisticSearchEngine::stateValueCache.end()) {
         // This state has already been solved before
-        trialReward = ProbabilisticSearchEngine::stateValueCache
-        [states[stepsToGoInCurrentState]];
-        backupFunction->backupDecisionNodeLeaf(node, trialReward);
-        trialReward += node->immediateReward;
+        trialReward = it->second;
+        backupDecisionNodeLeaf(node);
 
         ++cacheHits;
         return true;
@@ -590,8 +1175,7 @@ bool THTS::currentStateIsSolved(SearchNode *node) {
 
         calcReward(states[stepsToGoInCurrentState], 0, trialReward);
         trialReward *= stepsToGoInCurrentState;
-        backupFunction->backupDecisionNodeLeaf(node, trialReward);
-        trialReward += node->immediateReward;
+        backupDecisionNodeLeaf(node);
 
         if (cachingEnabled) {
             assert(ProbabilisticSearchEngine::stateValueCache.find(
@@ -602,10 +1186,235 @@ bool THTS::currentStateIsSolved(SearchNode *node) {
                     node->getExpectedConcreteFutureRewardEstimate();
         }
         return true;
+    } else if (MathUtils::doubleIsGreater(tailSolverTimeout, 0.0) &&
+               (stepsToGoInCurrentState <= tailSolverDepth) &&
+               solveTail(states[stepsToGoInCurrentState], trialReward)) {
+        // The tail of the trial has been solved exactly
+        backupDecisionNodeLeaf(node);
+
+        if (cachingEnabled) {
+            ProbabilisticSearchEngine::stateValueCache
+            [states[stepsToGoInCurrentState]] =
+                    node->getExpectedConcreteFutureRewardEstimate();
+        }
+        return true;
     }
     return false;
 }
 
+bool THTS::solveTail(State const &state, double &value) {
+    PhaseTimer timer(PhaseTimer::TAIL_SOLVER);
+    tailSolverStopwatch.reset();
+    tailSolverAborted = false;
+    value = calcTailValue(state);
+
+    // The next deeper tail is tried if solving it is expected to take less
+    // than the timeout (i.e., if this call took less than the timeout divided
+    // by the branching factor)
+    double elapsedTime = tailSolverStopwatch();
+    if (tailSolverAborted) {
+        tailSolverDepth = std::max(2, tailSolverDepth - 1);
+        return false;
+    } else if ((numberOfTailExpansions > 0) &&
+               (tailSolverDepth < maxSearchDepthForThisStep) &&
+               MathUtils::doubleIsSmaller(
+                   elapsedTime * numberOfTailSuccessors /
+                       numberOfTailExpansions,
+                   tailSolverTimeout)) {
+        ++tailSolverDepth;
+    }
+    ++numberOfSolvedTails;
+    return true;
+}
+
+double THTS::calcTailValue(State const &state) {
+    double value = 0.0;
+    if (state.stepsToGo() == 1) {
+        calcOptimalFinalReward(state, value);
+        return value;
+    }
+
+    StateValueHashMap::iterator it = tailValues.find(state);
+    if (it != tailValues.end()) {
+        return it->second;
+    }
+    if (cachingEnabled) {
+        it = ProbabilisticSearchEngine::stateValueCache.find(state);
+        if (it != ProbabilisticSearchEngine::stateValueCache.end()) {
+            return it->second;
+        }
+    }
+
+    ++numberOfTailExpansions;
+    std::vector<int> actionsToExpand = getApplicableActions(state);
+    PDState successor(state.stepsToGo() - 1);
+    std::vector<double> deterministicStateFluents(
+        State::numberOfDeterministicStateFluents);
+    std::vector<double> probabilisticStateFluents(
+        State::numberOfProbabilisticStateFluents);
+    std::vector<int> outcome(State::numberOfProbabilisticStateFluents);
+
+    value = -std::numeric_limits<double>::max();
+    for (unsigned int index = 0; index < actionsToExpand.size(); ++index) {
+        if (actionsToExpand[index] != index) {
+            continue;
+        }
+        double reward = 0.0;
+        calcReward(state, index, reward);
+        successor.reset(state.stepsToGo() - 1);
+        calcSuccessorState(state, index, successor);
+        for (unsigned int i = 0; i < State::numberOfDeterministicStateFluents;
+             ++i) {
+            deterministicStateFluents[i] = successor.deterministicStateFluent(i);
+        }
+
+        // Enumerate all outcomes of the probabilistic state fluents
+        std::fill(outcome.begin(), outcome.end(), 0);
+        double expectedValue = 0.0;
+        bool outcomesLeft = true;
+        while (outcomesLeft) {
+            double prob = 1.0;
+            for (unsigned int i = 0;
+                 i < State::numberOfProbabilisticStateFluents; ++i) {
+                DiscretePD const &pd = successor.probabilisticStateFluentAsPD(i);
+                probabilisticStateFluents[i] = pd.values[outcome[i]];
+                prob *= pd.probabilities[outcome[i]];
+            }
+
+            // The timeout is not checked for each successor since that is
+            // expensive in comparison to the evaluation of a small state
+            ++numberOfTailSuccessors;
+            if (((numberOfTailSuccessors % 64) == 0) &&
+                MathUtils::doubleIsGreater(tailSolverStopwatch(),
+                                           tailSolverTimeout)) {
+                tailSolverAborted = true;
+            }
+            if (tailSolverAborted) {
+                return 0.0;
+            }
+
+            State next(deterministicStateFluents, probabilisticStateFluents,
+                       state.stepsToGo() - 1);
+            State::calcStateFluentHashKeys(next);
+            State::calcStateHashKey(next);
+            expectedValue += prob * calcTailValue(next);
+            if (tailSolverAborted) {
+                return 0.0;
+            }
+
+            outcomesLeft = false;
+            for (unsigned int i = 0;
+                 i < State::numberOfProbabilisticStateFluents; ++i) {
+                ++outcome[i];
+                if (outcome[i] <
+                    successor.probabilisticStateFluentAsPD(i).size()) {
+                    outcomesLeft = true;
+                    break;
+                }
+                outcome[i] = 0;
+            }
+        }
+        value = std::max(value, reward + expectedValue);
+    }
+
+    tailValues[state] = value;
+    return value;
+}
+
+bool THTS::shareTransposition(SearchNode *node) {
+    if ((node == currentRootNode) || !node->children.empty()) {
+        return false;
+    }
+
+    State const &state = states[stepsToGoInCurrentState];
+    TranspositionTable::iterator it = transpositions.find(state);
+    if (it == transpositions.end()) {
+        transpositions[state] = node;
+        return false;
+    }
+
+    // Solved nodes are not shared since the trial could not continue below
+    // node if all its children are solved
+    SearchNode *representative = it->second;
+    if (!representative->initialized || representative->solved) {
+        return false;
+    }
+    node->children = representative->children;
+    node->futureReward = representative->futureReward;
+    node->numberOfVisits = representative->numberOfVisits;
+    node->initialized = true;
+    pq.insert(node);
+    ++numberOfTranspositions;
+    return true;
+}
+
+bool THTS::transpositionIsSolved(SearchNode *node) {
+    if (!node->initialized || node->solved || node->children.empty()) {
+        return false;
+    }
+
+    double futureReward = -std::numeric_limits<double>::max();
+    for (SearchNode *child : node->children) {
+        if (child) {
+            if (!child->initialized || !child->solved) {
+                return false;
+            }
+            futureReward = std::max(futureReward,
+                                    child->getExpectedConcreteRewardEstimate());
+        }
+    }
+    trialReward = futureReward;
+    backupDecisionNodeLeaf(node);
+    return true;
+}
+
+void THTS::backupDecisionNodeLeaf(SearchNode *node) {
+    {
+        PhaseTimer timer(PhaseTimer::BACKUP);
+        backupFunction->backupDecisionNodeLeaf(node, trialReward);
+    }
+    trialReward += node->immediateReward;
+}
+
+void THTS::calcSuccessorDistribution(SearchNode *actionNode) {
+    PDState &successor = states[stepsToGoInNextState];
+    if (actionNode->transitionIndex >= 0) {
+        PhaseTimer timer(PhaseTimer::SUCCESSOR_COMPUTATION);
+        MemoizedTransition const &transition =
+            memoizedTransitions[actionNode->transitionIndex];
+        successor.setTo(transition.successor);
+        lastProbabilisticVarIndex = transition.lastProbabilisticVarIndex;
+        return;
+    }
+
+    calcSuccessorState(states[stepsToGoInCurrentState], appliedActionIndex,
+                       successor);
+
+    lastProbabilisticVarIndex = -1;
+    for (unsigned int i = 0; i < State::numberOfProbabilisticStateFluents;
+         ++i) {
+        if (successor.probabilisticStateFluentAsPD(i).isDeterministic()) {
+            successor.probabilisticStateFluent(i) =
+                successor.probabilisticStateFluentAsPD(i).values[0];
+        } else {
+            lastProbabilisticVarIndex = i;
+        }
+    }
+
+    if (numberOfMemoizedTransitions < maxNumberOfMemoizedTransitions) {
+        // The memoized states are allocated once and overwritten in later steps
+        if (numberOfMemoizedTransitions == memoizedTransitions.size()) {
+            memoizedTransitions.push_back(MemoizedTransition());
+        }
+        MemoizedTransition &transition =
+            memoizedTransitions[numberOfMemoizedTransitions];
+        transition.successor.setTo(successor);
+        transition.lastProbabilisticVarIndex = lastProbabilisticVarIndex;
+        actionNode->transitionIndex = numberOfMemoizedTransitions;
+        ++numberOfMemoizedTransitions;
+    }
+}
+
 void THTS::visitChanceNode(SearchNode *node) {
     while (states[stepsToGoInNextState]
             .probabilisticStateFluentAsPD(chanceNodeVarIndex)
@@ -613,9 +1422,15 @@ void THTS::visitChanceNode(SearchNode *node) {
         ++chanceNodeVarIndex;
     }
 
-    chosenOutcome = outcomeSelection->selectOutcome(
-            node, states[stepsToGoInNextState], chanceNodeVarIndex,
-            lastProbabilisticVarIndex);
+    // The chosen outcome is new if outcome selection has created a node
+    int numberOfNodes = lastUsedNodePoolIndex;
+    {
+        PhaseTimer timer(PhaseTimer::OUTCOME_SELECTION);
+        chosenOutcome = outcomeSelection->selectOutcome(
+                node, states[stepsToGoInNextState], chanceNodeVarIndex,
+                lastProbabilisticVarIndex);
+    }
+    VisitedChild visited(chosenOutcome, lastUsedNodePoolIndex > numberOfNodes);
 
     if (chanceNodeVarIndex == lastProbabilisticVarIndex) {
         State::calcStateFluentHashKeys(states[stepsToGoInNextState]);
@@ -626,21 +1441,40 @@ void THTS::visitChanceNode(SearchNode *node) {
         ++chanceNodeVarIndex;
         visitChanceNode(chosenOutcome);
     }
-    backupFunction->backupChanceNode(node, trialReward);
+    PhaseTimer timer(PhaseTimer::BACKUP);
+    backupFunction->backupChanceNode(node, trialReward, visited);
 }
 
 void THTS::visitDummyChanceNode(SearchNode *node) {
     State::calcStateFluentHashKeys(states[stepsToGoInNextState]);
     State::calcStateHashKey(states[stepsToGoInNextState]);
 
-    if (node->children.empty()) {
+    bool isNew = node->children.empty();
+    if (isNew) {
         node->children.resize(1, nullptr);
         node->children[0] = createDecisionNode(1.0);
     }
     assert(node->children.size() == 1);
+    VisitedChild visited(node->children[0], isNew);
 
     visitDecisionNode(node->children[0]);
-    backupFunction->backupChanceNode(node, trialReward);
+    PhaseTimer timer(PhaseTimer::BACKUP);
+    backupFunction->backupChanceNode(node, trialReward, visited);
+}
+
+void THTS::visitJointChanceNode(SearchNode *node) {
+    int numberOfNodes = lastUsedNodePoolIndex;
+    {
+        PhaseTimer timer(PhaseTimer::OUTCOME_SELECTION);
+        chosenOutcome = outcomeSelection->selectJointOutcome(
+                node, states[stepsToGoInNextState], lastProbabilisticVarIndex);
+    }
+    VisitedChild visited(chosenOutcome, lastUsedNodePoolIndex > numberOfNodes);
+    State::calcStateFluentHashKeys(states[stepsToGoInNextState]);
+
+    visitDecisionNode(chosenOutcome);
+    PhaseTimer timer(PhaseTimer::BACKUP);
+    backupFunction->backupChanceNode(node, trialReward, visited);
 }
 
 /******************************************************************
@@ -686,16 +1520,16 @@ int THTS::getUniquePolicy() {
                         Memory management
 ******************************************************************/
 
+void THTS::growNodePool(size_t minSize) {
+    size_t newSize = std::max(minSize, nodePool.size() + nodePoolChunkSize);
+    nodePool.resize(std::min(newSize, getNodePoolCapacity()), nullptr);
+}
+
 SearchNode *THTS::createRootNode() {
-    for (SearchNode *node : nodePool) {
-        if (node) {
-            if (!node->children.empty()) {
-                std::vector<SearchNode *> tmp;
-                node->children.swap(tmp);
-            }
-        } else {
-            break;
-        }
+    // The nodes of the previous tree are reset when they are reused, so
+    // nothing has to be done to release them
+    if (nodePool.empty()) {
+        growNodePool(1);
     }
 
     SearchNode *res = nodePool[0];
@@ -713,6 +1547,9 @@ SearchNode *THTS::createRootNode() {
 }
 
 SearchNode *THTS::createDecisionNode(double const &prob) {
+    if (lastUsedNodePoolIndex == nodePool.size()) {
+        growNodePool(lastUsedNodePoolIndex + 1);
+    }
     assert(lastUsedNodePoolIndex < nodePool.size());
 
     SearchNode *res = nodePool[lastUsedNodePoolIndex];
@@ -733,6 +1570,9 @@ SearchNode *THTS::createDecisionNode(double const &prob) {
 }
 
 SearchNode *THTS::createChanceNode(double const &prob, bool isActionNode) {
+    if (lastUsedNodePoolIndex == nodePool.size()) {
+        growNodePool(lastUsedNodePoolIndex + 1);
+    }
     assert(lastUsedNodePoolIndex < nodePool.size());
 
     SearchNode *res = nodePool[lastUsedNodePoolIndex];
@@ -776,9 +1616,41 @@ void THTS::printStats(std::ostream &out, bool const &printRoundStats,
         out << indent << "Created SearchNodes: " << lastUsedNodePoolIndex
             << std::endl;
         out << indent << "Cache Hits: " << cacheHits << std::endl;
+        if (maxNumberOfMemoizedTransitions > 0) {
+            out << indent << "Memoized transitions: "
+                << numberOfMemoizedTransitions << std::endl;
+        }
+        if (numberOfReusedNodes > 0) {
+            out << indent << "Reused SearchNodes: " << numberOfReusedNodes
+                << " (after " << numberOfPonderingTrials
+                << " pondering trials)" << std::endl;
+        }
+        if (numberOfSolvedTails > 0) {
+            out << indent << "Solved tails: " << numberOfSolvedTails
+                << " (tail solver depth: " << tailSolverDepth << ")"
+                << std::endl;
+        }
+        if (numberOfTranspositions > 0) {
+            out << indent << "Transpositions: " << numberOfTranspositions
+                << std::endl;
+        }
+        if (numberOfRecyclings > 0) {
+            out << indent << "Recycled SearchNodes: " << numberOfRecycledNodes
+                << " (in " << numberOfRecyclings << " recyclings)"
+                << std::endl;
+        }
+        if (numberOfRestoredNodes > 0) {
+            out << indent << "Reused SearchNodes: " << numberOfRestoredNodes
+                << " (from an earlier round)" << std::endl;
+        }
+        if (stoppedEarly) {
+            out << indent << "Search stopped early (best action is clear)"
+                << std::endl;
+        }
         actionSelection->printStats(out, indent);
         outcomeSelection->printStats(out, indent);
         backupFunction->printStats(out, indent);
+        PhaseTimer::printStepStats(out, indent);
     }
     if (initializer) {
         initializer->printStats(out, printRoundStats, indent + "  ");
@@ -807,16 +1679,56 @@ void THTS::printStats(std::ostream &out, bool const &printRoundStats,
             << accumulatedNumberOfTrialsInRootState << std::endl;
         out << indent << "Accumulated number of search nodes in root state: "
             << accumulatedNumberOfSearchNodesInRootState << std::endl;
+        out << indent << "Number of steps where the search stopped early: "
+            << numberOfEarlyTerminations << std::endl;
     }
 }
 
+void THTS::collectStepStats(StatsRecord& record) const {
+    record.add("trials", currentTrial);
+    record.add("search nodes", lastUsedNodePoolIndex);
+    record.add("cache hits", cacheHits);
+    record.add("memoized transitions", numberOfMemoizedTransitions);
+    record.add("reused search nodes", numberOfReusedNodes);
+    record.add("restored search nodes", numberOfRestoredNodes);
+    record.add("recycled search nodes", numberOfRecycledNodes);
+    record.add("transpositions", numberOfTranspositions);
+    record.add("solved tails", numberOfSolvedTails);
+    record.add("stopped early", stoppedEarly ? 1 : 0);
+    record.add("equivalence classes", numberOfEQclasses);
+    record.add("search time", searchTime);
+    record.add("abstraction time", abstractionTime);
+    if (currentRootNode) {
+        // Q-values of the root actions (null for unreasonable actions)
+        std::vector<double> qValues(currentRootNode->children.size(),
+                                    std::numeric_limits<double>::quiet_NaN());
+        for (unsigned int i = 0; i < currentRootNode->children.size(); ++i) {
+            if (currentRootNode->children[i]) {
+                qValues[i] = currentRootNode->children[i]
+                                 ->getExpectedConcreteRewardEstimate();
+            }
+        }
+        record.add("q-values", qValues);
+    }
+}
+
+void THTS::collectPonderingStats(StatsRecord& record) const {
+    // The counters are those of the last pondering if there was none after
+    // the last step
+    bool pondered = (ponderedActionIndex >= 0);
+    record.add("pondering trials", pondered ? numberOfPonderingTrials : 0);
+    record.add("pondering search nodes",
+               pondered ? numberOfPonderingNodes : 0);
+}
 
 /******************************************************************
                     generate Equivalence Class
 ******************************************************************/
 
 void THTS::generateEquivalenceClass() {
-     std::cout <<"size is "<<pq.size() << std::endl;
+    if (!quiet) {
+        std::cout <<"size is "<<pq.size() << std::endl;
+    }
     // std::cout <<"size of qvaluemean"<<SearchNode::qvalueMean.size() << std::endl;
 
 
@@ -981,7 +1893,9 @@ void THTS::generateEquivalenceClass() {
 
     }
 
-    std::cout <<"before makeQmean " <<numberOfEQclasses <<" classes "<<std::endl;
+    if (!quiet) {
+        std::cout <<"before makeQmean " <<numberOfEQclasses <<" classes "<<std::endl;
+    }
     makeQmean();    //here the vector is generated for the Qmean with vector qsum and qnumberofEqclass
     //std::cout <<"finished generating there are " <<numberOfEQclasses <<"classes "<<std::endl;
 
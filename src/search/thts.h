@@ -46,7 +46,9 @@ struct SearchNode {
           solved(false),
           isChanceNode(false),
           isActionNode(false),
-          equivalenceClassPos(-1){}
+          equivalenceClassPos(-1),
+          transitionIndex(-1),
+          childWeightSum(0.0) {}
 
 
     ~SearchNode() {
@@ -69,6 +71,8 @@ struct SearchNode {
 		isChanceNode = false;
         isActionNode = false;
         equivalenceClassPos=-1;//empty
+        transitionIndex = -1;
+        childWeightSum = 0.0;
     }
 
 
@@ -174,6 +178,14 @@ struct SearchNode {
     //number of the equivalenzclass
     int equivalenceClassPos;
 
+    // In action nodes, the index of the memoized successor distribution in
+    // THTS::memoizedTransitions (-1 if it is not memoized)
+    int transitionIndex;
+
+    // In chance nodes with incremental backups, the sum of the weights of the
+    // children in the weighted average that is stored in futureReward
+    double childWeightSum;
+
 
 };
 
@@ -199,6 +211,15 @@ public:
     // Learns parameter values from a random training set
     void learn() override;
 
+    // This is called at the beginning of each round and after each step, and
+    // is passed on to the ingredients
+    void initRound() override;
+    void finishStep() override;
+
+    // Learned parameters are only determined by the initializer
+    void writeLearnedParameters(std::ostream& out) const override;
+    bool readLearnedParameters(std::istream& in) override;
+
     // Start the search engine as main search engine
     void estimateBestActions(State const& _rootState,
                              std::vector<int>& bestActions) override;
@@ -217,6 +238,12 @@ public:
         assert(false);
     }
 
+    // Continues the search with trials that start with the submitted action,
+    // i.e., in the subtree of the root node that contains the next root node.
+    // If the next state is part of that subtree, the search of the next step
+    // starts with the subtree instead of an empty tree.
+    bool ponder(int actionIndex, double const& time) override;
+
     // Parameter setter
     void setActionSelection(ActionSelection* _actionSelection);
     void setOutcomeSelection(OutcomeSelection* _outcomeSelection);
@@ -234,6 +261,41 @@ public:
         maxNumberOfTrials = _maxNumberOfTrials;
     }
 
+    void setStabilityWindow(int _stabilityWindow) {
+        stabilityWindow = _stabilityWindow;
+    }
+
+    void setConfidenceFactor(double _confidenceFactor) {
+        confidenceFactor = _confidenceFactor;
+    }
+
+    void setUseJointOutcomes(bool _useJointOutcomes);
+
+    void setTailSolverTimeout(double _tailSolverTimeout) {
+        tailSolverTimeout = _tailSolverTimeout;
+    }
+
+    void setUseTranspositions(bool _useTranspositions) {
+        useTranspositions = _useTranspositions;
+    }
+
+    void setRecycleFraction(double _recycleFraction) {
+        recycleFraction = _recycleFraction;
+    }
+
+    void setMaxNumberOfMemoizedTransitions(
+        int _maxNumberOfMemoizedTransitions) {
+        maxNumberOfMemoizedTransitions = _maxNumberOfMemoizedTransitions;
+    }
+
+    void setKeptTreeBudget(int _keptTreeBudget) {
+        keptTreeBudget = _keptTreeBudget;
+    }
+
+    void setNumberOfStepsWithKeptTrees(int _numberOfStepsWithKeptTrees) {
+        numberOfStepsWithKeptTrees = _numberOfStepsWithKeptTrees;
+    }
+
     void setNumberOfNewDecisionNodesPerTrial(
         int _numberOfNewDecisionNodesPerTrial) {
         numberOfNewDecisionNodesPerTrial = _numberOfNewDecisionNodesPerTrial;
@@ -241,10 +303,11 @@ public:
 
     void setMaxNumberOfNodes(int _maxNumberOfNodes) {
         maxNumberOfNodes = _maxNumberOfNodes;
-        // Resize the node pool and give it a "safety net" of 20000 nodes (this
-        // is because the termination criterion is checked only at the root and
-        // not in the middle of a trial)
-        nodePool.resize(maxNumberOfNodes + 20000, nullptr);
+        // The node pool grows on demand, it is only truncated here if it is
+        // already larger than allowed
+        if (nodePool.size() > getNodePoolCapacity()) {
+            nodePool.resize(getNodePoolCapacity());
+        }
     }
     //compare method for SearchNode used in the priority queue
     struct CompareSearchNodeDepth {
@@ -267,6 +330,12 @@ public:
     SearchNode* createDecisionNode(double const& _prob);
     SearchNode* createChanceNode(double const& _prob,  bool isActionNode);
 
+    // Returns a reference to the child of the action node that represents the
+    // joint outcome with the given state hash key (nullptr if there is none)
+    SearchNode*& getJointOutcome(SearchNode* actionNode, long hashKey) {
+        return jointOutcomes[std::make_pair(actionNode, hashKey)];
+    }
+
 
 
     // Methods that return certain nodes of the explicated tree
@@ -278,9 +347,15 @@ public:
         return tipNodeOfTrial;
     }
 
+    bool usesTranspositions() const {
+        return useTranspositions;
+    }
+
     // Print
     void printStats(std::ostream& out, bool const& printRoundStats,
                     std::string indent = "") const override;
+    void collectStepStats(StatsRecord& record) const override;
+    void collectPonderingStats(StatsRecord& record) const override;
 
 
     /*new */
@@ -291,9 +366,9 @@ private:
     void visitDecisionNode(SearchNode* node);
     void visitChanceNode(SearchNode* node);
     void visitDummyChanceNode(SearchNode* node);
+    void visitJointChanceNode(SearchNode* node);
 
     // Initialization of different search phases
-    void initRound();
     void initStep(State const& _rootState);
     void initTrial();
     void initTrialStep();
@@ -307,6 +382,15 @@ private:
     // now
     bool currentStateIsSolved(SearchNode* node);
 
+    // Computes the successor distribution of the current state under the
+    // applied action in states[stepsToGoInNextState], or copies it from the
+    // action node if it is memoized
+    void calcSuccessorDistribution(SearchNode* actionNode);
+
+    // Backs up trialReward in a decision node that is treated as a leaf and
+    // adds its immediate reward to trialReward
+    void backupDecisionNodeLeaf(SearchNode* node);
+
     // If the root state is a reward lock or has only one reasonable action,
     // noop or the only reasonable action is returned
     int getUniquePolicy();
@@ -314,6 +398,92 @@ private:
     // Determine if another trial is performed
     bool moreTrials();
 
+    // Checks if the timeout is reached. If the maximal timeout is larger than
+    // the timeout, the search stops after half of the timeout if the decision
+    // is clear, and it continues until the maximal timeout if it is not
+    bool timeoutReached();
+
+    // Updates the best and second best action in the root node
+    void updateBestRootActions();
+
+    // Checks if the search can be stopped before the termination criterion is
+    // met because the best action in the root node is clear. This is the case
+    // if it has been the best action for stabilityWindow trials, or if the
+    // confidence intervals of the Q-values of the best and second best action
+    // (scaled by confidenceFactor) are disjoint
+    bool earlyTerminationReached() const;
+
+    // Returns the decision node that represents the given state in the subtree
+    // of the pondered action, or nullptr if there is no such node
+    SearchNode* getPonderedSuccessor(State const& nextState);
+
+    // The node pool has a "safety net" of 20000 nodes (this is because the
+    // termination criterion is checked only at the root and not in the middle
+    // of a trial)
+    size_t getNodePoolCapacity() const {
+        return maxNumberOfNodes + 20000;
+    }
+
+    // Enlarges the node pool by a chunk of nodePoolChunkSize entries or to
+    // minSize entries if that is larger (but never beyond its capacity). The
+    // SearchNodes themselves are only allocated when they are first needed.
+    void growNodePool(size_t minSize);
+
+    // Makes node the root node of the tree by moving all nodes of its subtree
+    // to the front of the node pool (the other nodes are released)
+    void reuseSubtree(SearchNode* node);
+
+    // Moves all nodes of the subtree of node to the front of the node pool,
+    // releases all other nodes and returns the (sorted) nodes of the subtree
+    std::vector<SearchNode*> compactNodePool(SearchNode* node);
+
+    // If a decision node of the same state (with the same remaining steps) has
+    // already been initialized in this step, node shares its children
+    // (i.e., its subtree) and its statistics, and true is returned
+    bool shareTransposition(SearchNode* node);
+
+    // Computes the exact value of state (which must have at most
+    // tailSolverDepth remaining steps) with an expectimax search over the
+    // real transition distributions. Returns false if this takes longer than
+    // tailSolverTimeout, and adapts tailSolverDepth to the branching factor
+    // and the time that was needed.
+    bool solveTail(State const& state, double& value);
+    double calcTailValue(State const& state);
+
+    // Returns true and backs up node as a leaf if all its children have been
+    // solved (this is only possible if the children are shared with a
+    // transposition that has been visited via another parent)
+    bool transpositionIsSolved(SearchNode* node);
+
+    // Releases the least visited subtrees (and solved ones first) when the
+    // node pool is full, such that at least recycleFraction of the maximal
+    // number of nodes becomes available
+    void recycleNodes();
+
+    // Inserts all nodes of a tree that has been built in an earlier step into
+    // the multiset that is used to generate the equivalence classes
+    void initAbstractionOfReusedTree();
+
+    // A tree of an early step that is kept for later rounds. The nodes are
+    // not part of the node pool while the tree is kept.
+    struct KeptTree {
+        SearchNode* root;
+        std::vector<SearchNode*> nodes;
+        int numberOfVisits;
+    };
+
+    // Moves the current tree from the node pool to the kept trees if it fits
+    // into the budget (trees of states that are visited less often are
+    // discarded to make room)
+    void keepCurrentTree();
+
+    // Moves the nodes of the kept tree back to the front of the node pool and
+    // makes its root the current root node
+    void restoreKeptTree(KeptTree& tree);
+
+    // Deletes the nodes of a kept tree
+    void discardKeptTree(KeptTree& tree);
+
     // Ingredients that are implemented externally
     ActionSelection* actionSelection;
     OutcomeSelection* outcomeSelection;
@@ -356,13 +526,65 @@ private:
     // transition
     int lastProbabilisticVarIndex;
 
+    // If joint outcomes are used, the children of an action node are the
+    // decision nodes of the sampled successor states (instead of a layer of
+    // chance nodes for each probabilistic state fluent), and this maps an
+    // action node and the hash key of a successor state to the decision node
+    struct JointOutcomeHash {
+        size_t operator()(std::pair<SearchNode*, long> const& key) const {
+            return std::hash<SearchNode*>()(key.first) * 31 +
+                   std::hash<long>()(key.second);
+        }
+    };
+    typedef std::unordered_map<std::pair<SearchNode*, long>, SearchNode*,
+                               JointOutcomeHash>
+        JointOutcomeMap;
+    JointOutcomeMap jointOutcomes;
+
+    // The tail solver solves decision nodes with at most tailSolverDepth
+    // remaining steps exactly (if tailSolverTimeout is positive). The values
+    // of the solved states are memoized in tailValues in the current step.
+    // The branching factor is estimated as the number of successor states of
+    // an expanded state, averaged over all calls in this run.
+    int tailSolverDepth;
+    StateValueHashMap tailValues;
+    Stopwatch tailSolverStopwatch;
+    bool tailSolverAborted;
+    long numberOfTailExpansions;
+    long numberOfTailSuccessors;
+    int numberOfSolvedTails;
+
+    // If transpositions are used, the first initialized decision node of each
+    // state in the current step is stored, and the decision nodes of the same
+    // state that are created later share its children, so the tree becomes a
+    // DAG. Each decision node keeps its own probability and immediate reward
+    // since these depend on the parent.
+    typedef std::unordered_map<State, SearchNode*, State::HashWithRemSteps,
+                               State::EqualWithRemSteps>
+        TranspositionTable;
+    TranspositionTable transpositions;
+    int numberOfTranspositions;
+
+    // The successor distributions of action nodes are memoized since they are
+    // the same in each trial that passes the node (at most
+    // maxNumberOfMemoizedTransitions per step)
+    struct MemoizedTransition {
+        PDState successor;
+        int lastProbabilisticVarIndex;
+    };
+    std::vector<MemoizedTransition> memoizedTransitions;
+    int numberOfMemoizedTransitions;
+
     // Counter for the number of decision nodes that have been initialized in
     // the current trial
     int initializedDecisionNodes;
 
-    // Memory management (nodePool)
+    // Memory management (nodePool). Released nodes are not reset until they
+    // are used again, so their children may still point to other nodes of
+    // the pool (and must be cleared before a released node is deleted).
     int lastUsedNodePoolIndex;
     std::vector<SearchNode*> nodePool;
+    static size_t const nodePoolChunkSize = 1 << 16;
 
     // The stopwatch used for timeout check
     Stopwatch stopwatch;
@@ -374,6 +596,15 @@ private:
     int maxNumberOfTrials;
     int numberOfNewDecisionNodesPerTrial;
     int maxNumberOfNodes;
+    int stabilityWindow;
+    double confidenceFactor;
+    int keptTreeBudget;
+    int maxNumberOfMemoizedTransitions;
+    bool useJointOutcomes;
+    bool useTranspositions;
+    double tailSolverTimeout;
+    double recycleFraction;
+    int numberOfStepsWithKeptTrees;
 
     // Statistics
     int numberOfRuns;
@@ -383,12 +614,55 @@ private:
     int accumulatedNumberOfTrialsInRootState;
     int accumulatedNumberOfSearchNodesInRootState;
 
+    // Search and abstraction time of the current step
+    double searchTime;
+    double abstractionTime;
+
+    // The action of the last step that is used in pondering trials (-1 if
+    // there is no pondering), and if the search depth of the current step is
+    // limited by maxSearchDepth (in which case the tree cannot be reused)
+    int ponderedActionIndex;
+    bool searchDepthIsLimited;
+    int numberOfPonderingTrials;
+    int numberOfPonderingNodes;
+    int numberOfReusedNodes;
+    int numberOfRecycledNodes;
+    int numberOfRecyclings;
+
+    // The trees of the root states of the first numberOfStepsWithKeptTrees
+    // steps of a round are kept for later rounds (at most keptTreeBudget
+    // nodes in total). rootStateIsKept is true if the tree of the current
+    // root state is kept when the next step starts.
+    typedef std::unordered_map<State, KeptTree, State::HashWithRemSteps,
+                               State::EqualWithRemSteps>
+        KeptTreeMap;
+    KeptTreeMap keptTrees;
+    int numberOfKeptNodes;
+    bool rootStateIsKept;
+    State keptRootState;
+    int keptRootStateVisits;
+    int numberOfRestoredNodes;
+
+    // The actions with the highest Q-values in the root node and the trial in
+    // which the best action became the best action (used by the adaptive
+    // timeout and the early termination)
+    int bestRootActionIndex;
+    int bestRootActionTrial;
+    double bestRootQValue;
+    int secondBestRootActionIndex;
+    double secondBestRootQValue;
+    bool stoppedEarly;
+    int numberOfEarlyTerminations;
+
     // Tests which access private members
     friend class THTSTest;
     friend class BFSTestSearch;
     friend class MCUCTTestSearch;
     friend class UCTBaseTestSearch;
 
+    // Benchmark which accesses private members
+    friend class THTSBenchmark;
+
     //PriorityQueue
 public:
     std::multiset <SearchNode*,CompareSearchNodeDepth> pq;
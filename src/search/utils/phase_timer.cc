@@ -0,0 +1,114 @@
+#include "phase_timer.h"
+
+#include <chrono>
+#include <iomanip>
+
+using namespace std;
+
+bool PhaseTimer::enabled = false;
+double PhaseTimer::ticksPerSecond = 1.0;
+
+thread_local PhaseTimer::Phase PhaseTimer::activePhase =
+    PhaseTimer::NUMBER_OF_PHASES;
+thread_local unsigned long long PhaseTimer::activeSince = 0;
+
+thread_local unsigned long long
+    PhaseTimer::stepTicks[PhaseTimer::NUMBER_OF_PHASES] = {};
+thread_local long PhaseTimer::stepCalls[PhaseTimer::NUMBER_OF_PHASES] = {};
+thread_local unsigned long long
+    PhaseTimer::sessionTicks[PhaseTimer::NUMBER_OF_PHASES] = {};
+thread_local long PhaseTimer::sessionCalls[PhaseTimer::NUMBER_OF_PHASES] = {};
+
+void PhaseTimer::setEnabled(bool _enabled) {
+    enabled = _enabled;
+    if (enabled) {
+        ticksPerSecond = calibrate();
+    }
+}
+
+double PhaseTimer::calibrate() {
+    // Count the ticks during 10ms of wall clock time
+    chrono::steady_clock::time_point end =
+        chrono::steady_clock::now() + chrono::milliseconds(10);
+    unsigned long long startTicks = now();
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    chrono::steady_clock::time_point time = startTime;
+    while (time < end) {
+        time = chrono::steady_clock::now();
+    }
+    unsigned long long ticks = now() - startTicks;
+    chrono::duration<double> seconds = time - startTime;
+    return static_cast<double>(ticks) / seconds.count();
+}
+
+void PhaseTimer::initStep() {
+    for (int i = 0; i < NUMBER_OF_PHASES; ++i) {
+        sessionTicks[i] += stepTicks[i];
+        sessionCalls[i] += stepCalls[i];
+        stepTicks[i] = 0;
+        stepCalls[i] = 0;
+    }
+}
+
+void PhaseTimer::printStepStats(ostream& out, string indent) {
+    if (!enabled) {
+        return;
+    }
+    unsigned long long totalTicks = 0;
+    for (int i = 0; i < NUMBER_OF_PHASES; ++i) {
+        totalTicks += stepTicks[i];
+    }
+    out << indent << "Time per phase:" << endl;
+    for (int i = 0; i < NUMBER_OF_PHASES; ++i) {
+        double share = (totalTicks == 0) ? 0.0
+                                         : (100.0 * stepTicks[i] / totalTicks);
+        out << indent << "  " << getName(static_cast<Phase>(i)) << ": "
+            << (stepTicks[i] / ticksPerSecond) << "s (" << fixed
+            << setprecision(1) << share << "%, " << stepCalls[i] << " calls)"
+            << endl;
+        out.unsetf(ios_base::floatfield);
+        out << setprecision(6);
+    }
+}
+
+void PhaseTimer::printSessionSummary(ostream& out) {
+    if (!enabled) {
+        return;
+    }
+    out << "{";
+    for (int i = 0; i < NUMBER_OF_PHASES; ++i) {
+        if (i > 0) {
+            out << ", ";
+        }
+        out << "\"" << getName(static_cast<Phase>(i)) << "\": {\"time\": "
+            << ((sessionTicks[i] + stepTicks[i]) / ticksPerSecond)
+            << ", \"calls\": " << (sessionCalls[i] + stepCalls[i]) << "}";
+    }
+    out << "}" << endl;
+}
+
+string PhaseTimer::getName(Phase phase) {
+    switch (phase) {
+    case ACTION_SELECTION:
+        return "action selection";
+    case SUCCESSOR_COMPUTATION:
+        return "successor computation";
+    case OUTCOME_SELECTION:
+        return "outcome selection";
+    case INITIALIZATION:
+        return "initialization";
+    case BACKUP:
+        return "backup";
+    case REWARD_LOCK_DETECTION:
+        return "reward lock detection";
+    case CACHE_LOOKUP:
+        return "cache lookup";
+    case ABSTRACTION:
+        return "abstraction";
+    case TAIL_SOLVER:
+        return "tail solver";
+    case NUMBER_OF_PHASES:
+        break;
+    }
+    return "";
+}
@@ -0,0 +1,115 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+// Measures how the time of the search is distributed among the phases of a
+// trial. A PhaseTimer is created at the beginning of a phase and adds the
+// elapsed time to that phase when it is destroyed. If phases are nested (e.g.,
+// successor computations in a heuristic that is called by the initializer), the
+// time is only added to the innermost phase, so the times of all phases sum up
+// to the instrumented time. Time is measured in CPU cycles (on x86), which is
+// cheap enough to be used in the innermost loops of the search, and the
+// instrumentation only costs a branch if it is disabled (the default).
+
+#include <ostream>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+class PhaseTimer {
+public:
+    enum Phase {
+        ACTION_SELECTION,
+        SUCCESSOR_COMPUTATION,
+        OUTCOME_SELECTION,
+        INITIALIZATION,
+        BACKUP,
+        REWARD_LOCK_DETECTION,
+        CACHE_LOOKUP,
+        ABSTRACTION,
+        TAIL_SOLVER,
+        NUMBER_OF_PHASES
+    };
+
+    PhaseTimer(Phase _phase) : phase(_phase), parent(NUMBER_OF_PHASES) {
+        if (enabled) {
+            start();
+        }
+    }
+
+    ~PhaseTimer() {
+        if (enabled) {
+            stop();
+        }
+    }
+
+    static void setEnabled(bool _enabled);
+    static bool isEnabled() {
+        return enabled;
+    }
+
+    // Adds the times of the current step to the session and resets them
+    static void initStep();
+
+    // Prints the times and number of calls of the current step
+    static void printStepStats(std::ostream& out, std::string indent = "");
+
+    // Prints the times and number of calls of the whole session (including the
+    // current step) as a single JSON object
+    static void printSessionSummary(std::ostream& out);
+
+    static std::string getName(Phase phase);
+
+private:
+    static unsigned long long now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    void start() {
+        unsigned long long time = now();
+        parent = activePhase;
+        if (parent != NUMBER_OF_PHASES) {
+            stepTicks[parent] += time - activeSince;
+        }
+        activePhase = phase;
+        activeSince = time;
+    }
+
+    void stop() {
+        unsigned long long time = now();
+        stepTicks[phase] += time - activeSince;
+        ++stepCalls[phase];
+        activePhase = parent;
+        activeSince = time;
+    }
+
+    // Number of ticks of now() per second
+    static double calibrate();
+
+    Phase phase;
+    Phase parent;
+
+    static bool enabled;
+    static double ticksPerSecond;
+
+    // The innermost phase that is currently measured (NUMBER_OF_PHASES if
+    // there is none) and the tick at which it was entered or resumed
+    static thread_local Phase activePhase;
+    static thread_local unsigned long long activeSince;
+
+    static thread_local unsigned long long stepTicks[NUMBER_OF_PHASES];
+    static thread_local long stepCalls[NUMBER_OF_PHASES];
+    static thread_local unsigned long long sessionTicks[NUMBER_OF_PHASES];
+    static thread_local long sessionCalls[NUMBER_OF_PHASES];
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "stats_sink.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+ofstream StatsSink::file;
+
+StatsRecord::StatsRecord(string const& type) {
+    fields.precision(numeric_limits<double>::digits10 + 2);
+    fields << "{";
+    add("type", type);
+}
+
+void StatsRecord::add(string const& key, double value) {
+    addKey(key);
+    addValue(value);
+}
+
+void StatsRecord::add(string const& key, int value) {
+    addKey(key);
+    fields << value;
+}
+
+void StatsRecord::add(string const& key, long value) {
+    addKey(key);
+    fields << value;
+}
+
+void StatsRecord::add(string const& key, string const& value) {
+    addKey(key);
+    fields << "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            fields << '\\' << c;
+        } else if (c == '\n') {
+            fields << "\\n";
+        } else {
+            fields << c;
+        }
+    }
+    fields << "\"";
+}
+
+void StatsRecord::add(string const& key, vector<double> const& values) {
+    addKey(key);
+    fields << "[";
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            fields << ", ";
+        }
+        addValue(values[i]);
+    }
+    fields << "]";
+}
+
+void StatsRecord::addKey(string const& key) {
+    if (fields.tellp() > 1) {
+        fields << ", ";
+    }
+    fields << "\"" << key << "\": ";
+}
+
+void StatsRecord::addValue(double value) {
+    if (std::isfinite(value)) {
+        fields << value;
+    } else {
+        fields << "null";
+    }
+}
+
+bool StatsSink::open(string const& fileName) {
+    file.open(fileName.c_str(), ios::out | ios::trunc);
+    return file.is_open();
+}
+
+void StatsSink::write(StatsRecord const& record) {
+    if (file.is_open()) {
+        // Records are only written between steps, so flushing here does not
+        // influence the search time
+        file << record.toString() << endl;
+    }
+}
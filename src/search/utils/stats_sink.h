@@ -0,0 +1,54 @@
+#ifndef STATS_SINK_H
+#define STATS_SINK_H
+
+// Machine-readable statistics: a StatsRecord is a flat JSON object that is
+// built field by field, and the StatsSink writes one record per line to a file
+// (i.e., in the JSON Lines format), so the statistics of a run can be analyzed
+// without parsing the console output.
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class StatsRecord {
+public:
+    // Each record has a type (e.g., "step" or "round")
+    StatsRecord(std::string const& type);
+
+    void add(std::string const& key, double value);
+    void add(std::string const& key, int value);
+    void add(std::string const& key, long value);
+    void add(std::string const& key, std::string const& value);
+
+    // Non-finite values (e.g., of actions without Q-value) are written as null
+    void add(std::string const& key, std::vector<double> const& values);
+
+    std::string toString() const {
+        return fields.str() + "}";
+    }
+
+private:
+    void addKey(std::string const& key);
+    void addValue(double value);
+
+    std::ostringstream fields;
+};
+
+class StatsSink {
+public:
+    // Opens the file (which is truncated) and returns false if that fails
+    static bool open(std::string const& fileName);
+
+    static bool isOpen() {
+        return file.is_open();
+    }
+
+    // Does nothing if the sink is not open
+    static void write(StatsRecord const& record);
+
+private:
+    static std::ofstream file;
+};
+
+#endif
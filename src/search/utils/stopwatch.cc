@@ -1,5 +1,7 @@
 #include "stopwatch.h"
 
+#include <ctime>
+
 using namespace std::chrono;
 
 void Stopwatch::reset() {
@@ -17,11 +19,23 @@ void Stopwatch::continueTime() {
    // startTime.operator+=(time_span2);
 }
 
+double Stopwatch::savedTime() const {
+    duration<double> time_span = clocktime.time_since_epoch();
+    return time_span.count();
+}
+
 double Stopwatch::operator()() const {
     duration<double> time_span = steady_clock::now() - startTime;
     return time_span.count();
 }
 
+double CPUStopwatch::now() {
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) +
+           static_cast<double>(time.tv_nsec) / 1000000000.0;
+}
+
 std::ostream& operator<<(std::ostream& os, Stopwatch const& stopwatch) {
     os << stopwatch() << "s";
     return os;
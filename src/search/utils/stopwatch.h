@@ -15,6 +15,8 @@ public:
     void continueTime();
     // Returns the elapsed time since start
     double operator()() const;
+    // Returns the elapsed time up to the last call of saveTime
+    double savedTime() const;
 
 private:
     std::chrono::steady_clock::time_point startTime;
@@ -22,6 +24,28 @@ private:
     //double clocktime;
 };
 
+// Measure the CPU time the calling thread used since construction/reset. In
+// contrast to Stopwatch, this is not affected by other processes that compete
+// for the CPU.
+class CPUStopwatch {
+public:
+    CPUStopwatch() : startTime(now()) {}
+
+    void reset() {
+        startTime = now();
+    }
+
+    // Returns the CPU time used since start
+    double operator()() const {
+        return now() - startTime;
+    }
+
+private:
+    static double now();
+
+    double startTime;
+};
+
 // Convenience operator to stream elapsed time with seconds as unit
 std::ostream& operator<<(std::ostream& os, Stopwatch const& stopwatch);
 
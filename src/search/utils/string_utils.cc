@@ -269,3 +269,12 @@ bool StringUtils::startsWith(std::string const& s, std::string const& prefix) {
     std::string tmp = s.substr(0, prefix.length());
     return prefix == tmp;
 }
+
+unsigned long long StringUtils::computeHash(std::string const& s) {
+    unsigned long long result = 14695981039346656037ULL;
+    for (size_t i = 0; i < s.length(); ++i) {
+        result ^= static_cast<unsigned char>(s[i]);
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
@@ -37,6 +37,10 @@ public:
                                    std::string& value);
     static bool startsWith(std::string const& s, std::string const& prefix);
 
+    // Returns the 64-bit FNV-1a hash value of s (unlike std::hash, this is
+    // identical across platforms and compilers)
+    static unsigned long long computeHash(std::string const& s);
+
     template <typename T>
     static void concatenateNames(std::vector<T*>& tokens, std::string& res,
                                  char const& delimiter = '*') {
@@ -1,7 +1,9 @@
 #include "strxml.h"
 
+#include <cerrno>
 #include <sstream>
 #include <stack>
+#include <poll.h>
 #include <unistd.h>
 
 struct PSink {
@@ -27,42 +29,74 @@ private:
 
 static const std::string EMPTY_STRING;
 
-static std::string next_token(int fd) {
-    static char last_char = 0;
+// Reads the messages of the server in blocks instead of byte by byte. Since
+// the server can send several messages at once (e.g., the round-init message
+// and the first state), the buffered data is kept between calls of readNode.
+class XMLReader {
+public:
+    XMLReader() : fd(-1), pos(buffer), end(buffer) {}
 
-    std::string res;
-    if (last_char) {
-        res += last_char;
+    bool hasBufferedData(int _fd) const {
+        return (fd == _fd) && (pos != end);
     }
 
-    if (last_char == '<') {
-        last_char = 0;
-        return res;
+    void setFileDescriptor(int _fd) {
+        if (fd != _fd) {
+            fd = _fd;
+            pos = buffer;
+            end = buffer;
+        }
     }
 
-    if (last_char == '>') {
-        last_char = 0;
-        return res;
+    // Writes the next token to the given string, where a token is either "<",
+    // ">" or the (maximal) text in between. Returns false if the stream ends
+    // before the token is complete
+    bool nextToken(std::string& token) {
+        token.clear();
+        while (true) {
+            if (pos == end && !fill()) {
+                return false;
+            }
+            if (*pos == '<' || *pos == '>') {
+                if (token.empty()) {
+                    token += *pos;
+                    ++pos;
+                }
+                return true;
+            }
+            // Append the text up to the next delimiter (or the end of the
+            // buffer) at once
+            char const* start = pos;
+            while (pos != end && *pos != '<' && *pos != '>') {
+                ++pos;
+            }
+            token.append(start, pos - start);
+        }
     }
 
-    char next_char;
-    while (1) {
-        if (read(fd, &next_char, 1) != 1) {
-            return EMPTY_STRING;
-        }
-        if (next_char == '>' || next_char == '<') {
-            if (res.empty()) {
-                res += next_char;
-                last_char = 0;
-                return res;
-            }
-            last_char = next_char;
-            break;
+private:
+    bool fill() {
+        ssize_t bytesRead = 0;
+        do {
+            bytesRead = read(fd, buffer, BUFFER_SIZE);
+        } while (bytesRead < 0 && errno == EINTR);
+        if (bytesRead <= 0) {
+            return false;
         }
-        res += next_char;
+        pos = buffer;
+        end = buffer + bytesRead;
+        return true;
     }
-    return res;
-}
+
+    static const int BUFFER_SIZE = 65536;
+
+    int fd;
+    char buffer[BUFFER_SIZE];
+    char const* pos;
+    char const* end;
+};
+
+static XMLReader reader;
 
 static int token_type(char c) {
     if (c == '=')
@@ -135,19 +169,23 @@ static int do_node(const std::string& token, PSink& ps) {
 }
 
 static bool parse_node(int fd, PSink& ps) {
-    std::string token = next_token(fd);
+    reader.setFileDescriptor(fd);
+    std::string token;
+    std::string tag;
     int depth = 0;
-    while (!token.empty()) {
+    while (reader.nextToken(token)) {
         if (token == "<") {
-            int delta = do_node(next_token(fd), ps);
+            if (!reader.nextToken(tag)) {
+                break;
+            }
+            int delta = do_node(tag, ps);
             if (delta == -2) {
                 // cerr << "e1" << endl;
                 ps.formaterror();
                 return false;
             }
             depth += delta;
-            token = next_token(fd);
-            if (token != ">") {
+            if (!reader.nextToken(token) || token != ">") {
                 // cerr << "e2" << endl;
                 ps.formaterror();
                 return false;
@@ -158,7 +196,6 @@ static bool parse_node(int fd, PSink& ps) {
         } else {
             ps.pushText(token);
         }
-        token = next_token(fd);
     }
     ps.streamerror();
     return false;
@@ -233,6 +270,18 @@ const XMLNode* XMLNode::readNode(int fd) {
     }
 }
 
+/* Checks if data is available on the given file descriptor. */
+bool XMLNode::hasInput(int fd) {
+    if (reader.hasBufferedData(fd)) {
+        return true;
+    }
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, 0) > 0;
+}
+
 /* ====================================================================== */
 /* XMLText */
 
@@ -293,6 +342,13 @@ int XMLParent::size() const {
 
 /* Returns the text for this XML node. */
 std::string XMLParent::getText() const {
+    // Most nodes (e.g., the names and values of fluents) contain a single text
+    if (children.size() == 1) {
+        const XMLText* t = dynamic_cast<const XMLText*>(children[0]);
+        if (t != 0) {
+            return t->text;
+        }
+    }
     std::ostringstream os;
     for (node_vec::const_iterator ni = children.begin(); ni != children.end();
          ni++) {
@@ -17,6 +17,10 @@ typedef std::vector<const XMLNode*> node_vec;
 struct XMLNode {
     static const XMLNode* readNode(int fd);
 
+    // Returns true if readNode can read from the given file descriptor without
+    // waiting
+    static bool hasInput(int fd);
+
     virtual ~XMLNode() {}
 
     virtual const XMLNode* getChild(int /*i*/) const {
@@ -0,0 +1,258 @@
+// Microbenchmark of the generation of equivalence classes in THTS. A synthetic
+// tree is grown by trials that are similar to the trials of THTS (a decision
+// node is expanded when it is reached for the first time, and a trial ends
+// after the expansion), where all nodes are created with createDecisionNode
+// and createChanceNode. Each time the number of nodes reaches the next power of
+// ten, the time of generateEquivalenceClass and makeQmean and the number of
+// resulting equivalence classes are reported.
+//
+// The parsed task is only needed to set up THTS and is not used otherwise.
+
+#include "../../search/parser.h"
+#include "../../search/thts.h"
+
+#include "../../search/utils/random.h"
+#include "../../search/utils/stopwatch.h"
+#include "../../search/utils/system_utils.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static void printUsage() {
+    cout << "Usage: equivalenceClassBenchmark [options] [<parser output>]"
+         << endl
+         << endl;
+    cout << "  -d <int>" << endl;
+    cout << "    Depth of the tree in decision node layers (default: 10, at "
+            "most the horizon of the task)"
+         << endl;
+    cout << "  -b <int>" << endl;
+    cout << "    Number of actions of each decision node (default: 4)" << endl;
+    cout << "  -w <int>" << endl;
+    cout << "    Number of outcomes of each chance node (default: 2)" << endl;
+    cout << "  -l <int>" << endl;
+    cout << "    Number of chance node layers between two decision node "
+            "layers (default: 1)"
+         << endl;
+    cout << "  -v <int>" << endl;
+    cout << "    Number of distinct rewards and initial Q-values, or 0 for "
+            "values from [0,1) (default: 10)"
+         << endl;
+    cout << "  -n <int>" << endl;
+    cout << "    Maximal number of nodes (default: 100000)" << endl;
+    cout << "  -s <int>" << endl;
+    cout << "    Random seed (default: 1)" << endl;
+}
+
+class THTSBenchmark {
+public:
+    THTSBenchmark(int _depth, int _branching, int _width, int _layers,
+                  int _numberOfValues, int _maxNumberOfNodes, int seed)
+        : thts("THTS"),
+          depth(_depth),
+          branching(_branching),
+          width(_width),
+          layers(_layers),
+          numberOfValues(_numberOfValues),
+          maxNumberOfNodes(_maxNumberOfNodes) {
+        rnd.seed(seed);
+        thts.setMaxNumberOfNodes(maxNumberOfNodes);
+        // Rewards are computed for the first action and then overwritten
+        thts.appliedActionIndex = 0;
+        setStepsToGo(depth);
+        root = thts.createRootNode();
+    }
+
+    void run() {
+        cout << left << setw(12) << "Nodes" << setw(12) << "Multiset"
+             << setw(12) << "Classes" << setw(16) << "Abstraction [s]"
+             << setw(14) << "makeQmean [s]" << "ns/node" << endl;
+
+        long nextReport = 1000;
+        int trialsWithoutNewNodes = 0;
+        while (nextReport <= maxNumberOfNodes) {
+            while (thts.lastUsedNodePoolIndex < nextReport) {
+                if (trial()) {
+                    trialsWithoutNewNodes = 0;
+                } else if (++trialsWithoutNewNodes == 100000) {
+                    cout << "The tree is (almost) completely expanded" << endl;
+                    report();
+                    return;
+                }
+            }
+            report();
+            nextReport *= 10;
+        }
+    }
+
+private:
+    // Performs a trial and returns false if no node has been created
+    bool trial() {
+        int createdNodes = thts.lastUsedNodePoolIndex;
+        SearchNode* node = root;
+        while (node->initialized && node->stepsToGo > 1) {
+            node = node->children[rnd.genInt(0, node->children.size() - 1)];
+            for (int layer = 0; layer < layers; ++layer) {
+                node = sampleOutcome(node, layer == layers - 1);
+            }
+        }
+        if (!node->initialized) {
+            expand(node);
+        }
+        return thts.lastUsedNodePoolIndex > createdNodes;
+    }
+
+    void expand(SearchNode* node) {
+        setStepsToGo(node->stepsToGo);
+        node->children.resize(branching, nullptr);
+        for (int index = 0; index < branching; ++index) {
+            SearchNode* child = thts.createChanceNode(1.0, true);
+            child->futureReward = sampleValue();
+            child->initialized = true;
+            node->futureReward = max(node->futureReward, child->futureReward);
+            node->children[index] = child;
+            thts.pq.insert(child);
+        }
+        node->initialized = true;
+        thts.pq.insert(node);
+    }
+
+    SearchNode* sampleOutcome(SearchNode* node, bool isLastLayer) {
+        if (node->children.empty()) {
+            node->children.resize(width, nullptr);
+        }
+        int index = rnd.genInt(0, width - 1);
+        if (!node->children[index]) {
+            setStepsToGo(node->stepsToGo);
+            if (isLastLayer) {
+                SearchNode* child = thts.createDecisionNode(1.0 / width);
+                child->immediateReward = sampleValue();
+                if (child->stepsToGo == 1) {
+                    // Decision nodes with one step to go are solved and not
+                    // expanded
+                    child->futureReward = 0.0;
+                    child->solved = true;
+                    thts.pq.insert(child);
+                }
+                node->children[index] = child;
+            } else {
+                node->children[index] = thts.createChanceNode(1.0 / width,
+                                                              false);
+            }
+        }
+        return node->children[index];
+    }
+
+    void setStepsToGo(int stepsToGo) {
+        thts.stepsToGoInCurrentState = stepsToGo;
+        thts.stepsToGoInNextState = stepsToGo - 1;
+    }
+
+    double sampleValue() {
+        if (numberOfValues == 0) {
+            return rnd.genReal();
+        }
+        return rnd.genInt(0, numberOfValues - 1);
+    }
+
+    void report() {
+        // Suppress the output of generateEquivalenceClass
+        ostringstream discarded;
+        streambuf* coutBuffer = cout.rdbuf(discarded.rdbuf());
+        Stopwatch stopwatch;
+        thts.generateEquivalenceClass();
+        double abstractionTime = stopwatch();
+        cout.rdbuf(coutBuffer);
+
+        stopwatch.reset();
+        thts.makeQmean();
+        double qMeanTime = stopwatch();
+
+        cout << left << setw(12) << thts.lastUsedNodePoolIndex << setw(12)
+             << thts.pq.size() << setw(12) << thts.numberOfEQclasses
+             << setw(16) << fixed << setprecision(6) << abstractionTime
+             << setw(14) << qMeanTime << setprecision(1)
+             << (abstractionTime * 1e9 / thts.pq.size()) << endl;
+    }
+
+    THTS thts;
+    SearchNode* root;
+    RandomMT rnd;
+
+    int depth;
+    int branching;
+    int width;
+    int layers;
+    int numberOfValues;
+    long maxNumberOfNodes;
+};
+
+int main(int argc, char** argv) {
+    int depth = 10;
+    int branching = 4;
+    int width = 2;
+    int layers = 1;
+    int numberOfValues = 10;
+    int maxNumberOfNodes = 100000;
+    int seed = 1;
+    string problemFileName = "../test/testdomains/crossing_traffic_inst_mdp__1";
+
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (option == "-h" || option == "--help") {
+            printUsage();
+            return 0;
+        } else if (option[0] != '-') {
+            problemFileName = option;
+        } else if (i + 1 == argc) {
+            printUsage();
+            return 1;
+        } else {
+            int value = atoi(argv[++i]);
+            if (option == "-d") {
+                depth = value;
+            } else if (option == "-b") {
+                branching = value;
+            } else if (option == "-w") {
+                width = value;
+            } else if (option == "-l") {
+                layers = value;
+            } else if (option == "-v") {
+                numberOfValues = value;
+            } else if (option == "-n") {
+                maxNumberOfNodes = value;
+            } else if (option == "-s") {
+                seed = value;
+            } else {
+                printUsage();
+                return 1;
+            }
+        }
+    }
+
+    map<string, int> stateVariableIndices;
+    vector<vector<string>> stateVariableValues;
+    Parser parser(problemFileName);
+    parser.parseTask(stateVariableIndices, stateVariableValues);
+
+    if (depth < 1 || depth > SearchEngine::horizon) {
+        SystemUtils::abort("Error: the depth must be between 1 and the "
+                           "horizon of the task.");
+    }
+    if (branching < 1 || width < 1 || layers < 1 || numberOfValues < 0) {
+        SystemUtils::abort("Error: illegal tree parameters.");
+    }
+
+    cout << "Depth: " << depth << ", actions: " << branching
+         << ", outcomes: " << width << ", chance layers: " << layers
+         << ", values: " << numberOfValues << ", seed: " << seed << endl;
+
+    THTSBenchmark benchmark(depth, branching, width, layers, numberOfValues,
+                            maxNumberOfNodes, seed);
+    benchmark.run();
+    return 0;
+}
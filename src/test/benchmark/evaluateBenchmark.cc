@@ -0,0 +1,339 @@
+// Microbenchmark of the evaluation functions of Evaluatables. The task is
+// parsed, a set of reachable states is sampled by random walks from the initial
+// state, and each group of Evaluatables is evaluated on all sampled
+// state-action pairs with evaluate, evaluateToPD and evaluateToKleene, both
+// with the caching types that were chosen by the parser and without caching.
+// Afterwards, each Evaluatable is timed on its own with evaluate (or
+// evaluateToPD), and the times without caching are aggregated by the type of
+// the root of the formula, which shows which expressions are worth optimizing.
+//
+// Usage: evaluateBenchmark <parser output> [<samples>] [<repetitions>] [<seed>]
+
+#include "../../search/evaluatables.h"
+#include "../../search/parser.h"
+#include "../../search/search_engine.h"
+
+#include "../../search/utils/random.h"
+#include "../../search/utils/stopwatch.h"
+
+#include <cstdlib>
+#include <cxxabi.h>
+#include <iomanip>
+#include <iostream>
+#include <typeinfo>
+
+using namespace std;
+
+struct Sample {
+    Sample(State const& _state, int _actionIndex,
+           KleeneState const* _kleeneState)
+        : state(_state), actionIndex(_actionIndex), kleeneState(_kleeneState) {}
+
+    State state;
+    int actionIndex;
+
+    // The union of state and its successor (KleeneStates cannot be copied, so
+    // they are stored separately)
+    KleeneState const* kleeneState;
+};
+
+// Prevents that the compiler optimizes evaluations with unused results away
+static double sink = 0.0;
+
+static bool isApplicable(ActionState const& action, State const& state) {
+    double res = 0.0;
+    for (DeterministicEvaluatable* precond : action.actionPreconditions) {
+        precond->evaluate(res, state, action);
+        if (MathUtils::doubleIsEqual(res, 0.0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void sampleSuccessorState(State const& current, int actionIndex,
+                                 State& next, RandomMT& rnd) {
+    ActionState const& action = SearchEngine::actionStates[actionIndex];
+    next.reset(current.stepsToGo() - 1);
+    for (int i = 0; i < State::numberOfDeterministicStateFluents; ++i) {
+        SearchEngine::deterministicCPFs[i]->evaluate(
+            next.deterministicStateFluent(i), current, action);
+    }
+    for (int i = 0; i < State::numberOfProbabilisticStateFluents; ++i) {
+        DiscretePD pd;
+        SearchEngine::probabilisticCPFs[i]->evaluate(pd, current, action);
+        double randNum = rnd.genReal();
+        double probSum = 0.0;
+        double& value = next.probabilisticStateFluent(i);
+        value = pd.values.back();
+        for (size_t j = 0; j < pd.values.size(); ++j) {
+            probSum += pd.probabilities[j];
+            if (MathUtils::doubleIsSmaller(randNum, probSum)) {
+                value = pd.values[j];
+                break;
+            }
+        }
+    }
+    State::calcStateFluentHashKeys(next);
+    State::calcStateHashKey(next);
+}
+
+// Performs random walks with uniformly chosen applicable actions until
+// kleeneStates.size() state-action pairs have been collected
+static vector<Sample> sampleStates(vector<KleeneState>& kleeneStates,
+                                   RandomMT& rnd) {
+    vector<Sample> samples;
+    State current(SearchEngine::initialState);
+    while (samples.size() < kleeneStates.size()) {
+        if (current.stepsToGo() == 0) {
+            current = State(SearchEngine::initialState);
+        }
+
+        vector<int> applicable;
+        for (size_t i = 0; i < SearchEngine::actionStates.size(); ++i) {
+            if (isApplicable(SearchEngine::actionStates[i], current)) {
+                applicable.push_back(i);
+            }
+        }
+        assert(!applicable.empty());
+        int actionIndex = applicable[rnd.genInt(0, applicable.size() - 1)];
+
+        State next;
+        sampleSuccessorState(current, actionIndex, next, rnd);
+
+        KleeneState& kleeneState = kleeneStates[samples.size()];
+        kleeneState = KleeneState(current);
+        kleeneState |= KleeneState(next);
+        KleeneState::calcStateFluentHashKeys(kleeneState);
+        KleeneState::calcStateHashKey(kleeneState);
+        samples.push_back(Sample(current, actionIndex, &kleeneState));
+        current = next;
+    }
+    return samples;
+}
+
+static void evaluate(DeterministicEvaluatable* eval, Sample const& sample) {
+    double res = 0.0;
+    eval->evaluate(res, sample.state,
+                   SearchEngine::actionStates[sample.actionIndex]);
+    sink += res;
+}
+
+static void evaluate(ProbabilisticEvaluatable* eval, Sample const& sample) {
+    DiscretePD res;
+    eval->evaluate(res, sample.state,
+                   SearchEngine::actionStates[sample.actionIndex]);
+    sink += res.values.size();
+}
+
+static void evaluateToKleene(Evaluatable* eval, Sample const& sample) {
+    set<double> res;
+    eval->evaluateToKleene(res, *sample.kleeneState,
+                           SearchEngine::actionStates[sample.actionIndex]);
+    sink += res.size();
+}
+
+static long getNumberOfEvaluations(size_t numberOfEvals,
+                                   vector<Sample> const& samples,
+                                   int repetitions) {
+    return static_cast<long>(repetitions) * samples.size() * numberOfEvals;
+}
+
+// Evaluates each Evaluatable on each sample (once for warm up and repetitions
+// times with time measurement) and returns the average time per evaluation in
+// ns, with the caching types of the parser or without caching
+template <typename T, typename EvaluateFunction>
+static double measure(vector<T*> const& evals, vector<Sample> const& samples,
+                      int repetitions, bool caching,
+                      EvaluateFunction evaluateFunction) {
+    vector<Evaluatable::CachingType> cachingTypes;
+    vector<Evaluatable::CachingType> kleeneCachingTypes;
+    for (T* eval : evals) {
+        cachingTypes.push_back(eval->cachingType);
+        kleeneCachingTypes.push_back(eval->kleeneCachingType);
+        if (!caching) {
+            eval->cachingType = Evaluatable::NONE;
+            eval->kleeneCachingType = Evaluatable::NONE;
+        }
+    }
+
+    for (Sample const& sample : samples) {
+        for (T* eval : evals) {
+            evaluateFunction(eval, sample);
+        }
+    }
+
+    Stopwatch stopwatch;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        for (Sample const& sample : samples) {
+            for (T* eval : evals) {
+                evaluateFunction(eval, sample);
+            }
+        }
+    }
+    double time = stopwatch();
+
+    for (size_t i = 0; i < evals.size(); ++i) {
+        evals[i]->cachingType = cachingTypes[i];
+        evals[i]->kleeneCachingType = kleeneCachingTypes[i];
+    }
+    return time * 1e9 / getNumberOfEvaluations(evals.size(), samples,
+                                               repetitions);
+}
+
+// Prints the average time per evaluation of a group of Evaluatables
+template <typename T, typename EvaluateFunction>
+static void run(string const& group, string const& mode,
+                vector<T*> const& evals, vector<Sample> const& samples,
+                int repetitions, EvaluateFunction evaluateFunction) {
+    if (evals.empty()) {
+        return;
+    }
+
+    for (bool caching : {true, false}) {
+        double time = measure(evals, samples, repetitions, caching,
+                              evaluateFunction);
+        cout << left << setw(24) << group << setw(18) << mode << setw(9)
+             << (caching ? "yes" : "no") << right << setw(12)
+             << getNumberOfEvaluations(evals.size(), samples, repetitions)
+             << setw(16) << fixed << setprecision(1) << time << endl;
+    }
+}
+
+static string getRootType(Evaluatable const* eval) {
+    LogicalExpression const& root = *eval->formula;
+    char const* mangledName = typeid(root).name();
+    int status = 0;
+    char* name = abi::__cxa_demangle(mangledName, nullptr, nullptr, &status);
+    string result = (status == 0) ? name : mangledName;
+    free(name);
+    return result;
+}
+
+// The time without caching and the number of Evaluatables per root type
+struct RootTypeStats {
+    RootTypeStats() : time(0.0), numberOfEvals(0) {}
+
+    double time;
+    int numberOfEvals;
+};
+
+// Prints the average time per evaluation of each Evaluatable of a group, and
+// adds the times without caching to the stats of the root types
+template <typename T, typename EvaluateFunction>
+static void runPerEvaluatable(vector<T*> const& evals,
+                              vector<Sample> const& samples, int repetitions,
+                              EvaluateFunction evaluateFunction,
+                              map<string, RootTypeStats>& rootTypeStats) {
+    for (T* eval : evals) {
+        vector<T*> single(1, eval);
+        double cachedTime =
+            measure(single, samples, repetitions, true, evaluateFunction);
+        double time =
+            measure(single, samples, repetitions, false, evaluateFunction);
+        string rootType = getRootType(eval);
+        cout << left << setw(40) << eval->name << setw(28) << rootType << right
+             << setw(18) << fixed << setprecision(1) << cachedTime << setw(18)
+             << time << endl;
+
+        RootTypeStats& stats = rootTypeStats[rootType];
+        stats.time += time;
+        ++stats.numberOfEvals;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0]
+             << " <parser output> [<samples>] [<repetitions>] [<seed>]"
+             << endl;
+        return 1;
+    }
+    int numberOfSamples = (argc > 2) ? atoi(argv[2]) : 1000;
+    int repetitions = (argc > 3) ? atoi(argv[3]) : 10;
+    int seed = (argc > 4) ? atoi(argv[4]) : 1;
+
+    map<string, int> stateVariableIndices;
+    vector<vector<string>> stateVariableValues;
+    Parser parser(argv[1]);
+    parser.parseTask(stateVariableIndices, stateVariableValues);
+
+    RandomMT rnd;
+    rnd.seed(seed);
+    vector<KleeneState> kleeneStates(numberOfSamples);
+    vector<Sample> samples = sampleStates(kleeneStates, rnd);
+
+    vector<DeterministicEvaluatable*> reward = {SearchEngine::rewardCPF};
+    vector<DeterministicEvaluatable*> preconds(
+        SearchEngine::actionPreconditions.begin(),
+        SearchEngine::actionPreconditions.end());
+    vector<DeterministicEvaluatable*> detCPFs(
+        SearchEngine::deterministicCPFs.begin(),
+        SearchEngine::deterministicCPFs.end());
+    vector<ProbabilisticEvaluatable*> probCPFs(
+        SearchEngine::probabilisticCPFs.begin(),
+        SearchEngine::probabilisticCPFs.end());
+    vector<DeterministicEvaluatable*> determinizedCPFs(
+        SearchEngine::determinizedCPFs.begin(),
+        SearchEngine::determinizedCPFs.end());
+
+    cout << "Instance: " << argv[1] << endl;
+    cout << "Samples: " << samples.size() << ", repetitions: " << repetitions
+         << ", seed: " << seed << endl;
+    cout << left << setw(24) << "Expression" << setw(18) << "Mode" << setw(9)
+         << "Caching" << right << setw(12) << "Evaluations" << setw(16)
+         << "ns/evaluation" << endl;
+
+    auto det = [](DeterministicEvaluatable* eval, Sample const& sample) {
+        evaluate(eval, sample);
+    };
+    auto prob = [](ProbabilisticEvaluatable* eval, Sample const& sample) {
+        evaluate(eval, sample);
+    };
+    auto kleene = [](Evaluatable* eval, Sample const& sample) {
+        evaluateToKleene(eval, sample);
+    };
+
+    run("reward", "evaluate", reward, samples, repetitions, det);
+    run("reward", "evaluateToKleene", reward, samples, repetitions, kleene);
+    run("action preconditions", "evaluate", preconds, samples, repetitions,
+        det);
+    run("action preconditions", "evaluateToKleene", preconds, samples,
+        repetitions, kleene);
+    run("deterministic CPFs", "evaluate", detCPFs, samples, repetitions, det);
+    run("deterministic CPFs", "evaluateToKleene", detCPFs, samples,
+        repetitions, kleene);
+    run("probabilistic CPFs", "evaluateToPD", probCPFs, samples, repetitions,
+        prob);
+    run("probabilistic CPFs", "evaluateToKleene", probCPFs, samples,
+        repetitions, kleene);
+    run("determinized CPFs", "evaluate", determinizedCPFs, samples,
+        repetitions, det);
+
+    cout << endl
+         << left << setw(40) << "Evaluatable" << setw(28) << "Root type"
+         << right << setw(18) << "ns (caching)" << setw(18)
+         << "ns (no caching)" << endl;
+    map<string, RootTypeStats> rootTypeStats;
+    runPerEvaluatable(reward, samples, repetitions, det, rootTypeStats);
+    runPerEvaluatable(preconds, samples, repetitions, det, rootTypeStats);
+    runPerEvaluatable(detCPFs, samples, repetitions, det, rootTypeStats);
+    runPerEvaluatable(probCPFs, samples, repetitions, prob, rootTypeStats);
+
+    // Each Evaluatable is evaluated equally often, so the average time per
+    // evaluation of a root type is the average of the times of its
+    // Evaluatables
+    cout << endl
+         << left << setw(28) << "Root type" << right << setw(14)
+         << "Evaluatables" << setw(18) << "ns (no caching)" << endl;
+    for (auto const& entry : rootTypeStats) {
+        cout << left << setw(28) << entry.first << right << setw(14)
+             << entry.second.numberOfEvals << setw(18) << fixed
+             << setprecision(1)
+             << (entry.second.time / entry.second.numberOfEvals) << endl;
+    }
+
+    // Print the sink to make sure that all results are used
+    cout << "Checksum: " << sink << endl;
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "../gtest/gtest.h"
+
+#include "../../search/action_selection.h"
+
+#include "../../search/utils/random.h"
+
+#include <cmath>
+#include <vector>
+
+using std::vector;
+
+class UCB1ActionSelectionTest : public testing::Test {
+protected:
+    // The test bodies are subclasses of UCB1ActionSelectionTest, so they
+    // cannot access the private members of UCB1ActionSelection themselves
+    static void calcUCB1Scores(vector<double> const& values,
+                               vector<double> const& visits,
+                               vector<double>& scores,
+                               double const& magicConstant,
+                               double const& parentVisitPart) {
+        UCB1ActionSelection::calcUCB1Scores(values.data(), visits.data(),
+                                            scores.data(), values.size(),
+                                            magicConstant, parentVisitPart);
+    }
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    static void calcUCB1ScoresAVX2(vector<double> const& values,
+                                   vector<double> const& visits,
+                                   vector<double>& scores,
+                                   double const& magicConstant,
+                                   double const& parentVisitPart) {
+        UCB1ActionSelection::calcUCB1ScoresAVX2(
+            values.data(), visits.data(), scores.data(), values.size(),
+            magicConstant, parentVisitPart);
+    }
+#endif
+};
+
+// Tests that the scores computed with AVX2 are identical to the scalar ones,
+// also if the number of candidates is not a multiple of the vector width.
+TEST_F(UCB1ActionSelectionTest, testAVX2ScoresMatchScalarScores) {
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (!__builtin_cpu_supports("avx2")) {
+        return;
+    }
+    RandomMT rnd;
+    rnd.seed(1);
+    for (size_t n = 0; n < 20; ++n) {
+        vector<double> values(n);
+        vector<double> visits(n);
+        for (size_t i = 0; i < n; ++i) {
+            values[i] = rnd.genDouble(-100.0, 100.0);
+            visits[i] = rnd.genInt(1, 10000);
+        }
+        double magicConstant = rnd.genDouble(0.0, 200.0);
+        double parentVisitPart = std::log(rnd.genInt(1, 100000));
+
+        vector<double> scores(n);
+        vector<double> scoresAVX2(n);
+        calcUCB1Scores(values, visits, scores, magicConstant, parentVisitPart);
+        calcUCB1ScoresAVX2(values, visits, scoresAVX2, magicConstant,
+                           parentVisitPart);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(scores[i], scoresAVX2[i])
+                << "with " << n << " candidates at " << i;
+        }
+    }
+#endif
+}
@@ -0,0 +1,56 @@
+#include "../gtest/gtest.h"
+
+#include "../../search/depth_first_search.h"
+#include "../../search/parser.h"
+#include "../../search/prost_planner.h"
+
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+using std::numeric_limits;
+
+// Tests that incremental DFS computes the same Q-values as DFS when the search
+// depth is increased as in IDS, both with and without caching.
+TEST(IncrementalDepthFirstSearchTest, sameQValuesAsDepthFirstSearch) {
+    string problemFileName = "../test/testdomains/crossing_traffic_inst_mdp__1";
+    Parser parser(problemFileName);
+    map<string, int> stateVariableIndices;
+    vector<vector<string>> stateVariableValues;
+    parser.parseTask(stateVariableIndices, stateVariableValues);
+
+    for (int caching = 0; caching < 2; ++caching) {
+        DepthFirstSearch dfs;
+        IncrementalDepthFirstSearch incDfs;
+        dfs.setCachingEnabled(caching);
+        incDfs.setCachingEnabled(caching);
+
+        State state(SearchEngine::initialState);
+        vector<int> actionsToExpand(SearchEngine::numberOfActions);
+        for (size_t index = 0; index < actionsToExpand.size(); ++index) {
+            actionsToExpand[index] = index;
+        }
+        int maxDepth = std::min(6, SearchEngine::horizon);
+        for (int depth = 2; depth <= maxDepth; ++depth) {
+            state.stepsToGo() = depth;
+            vector<double> dfsQValues(SearchEngine::numberOfActions,
+                                      -numeric_limits<double>::max());
+            vector<double> incQValues(SearchEngine::numberOfActions,
+                                      -numeric_limits<double>::max());
+
+            DeterministicSearchEngine::stateValueCache.clear();
+            dfs.estimateQValues(state, actionsToExpand, dfsQValues);
+            DeterministicSearchEngine::stateValueCache.clear();
+            incDfs.estimateQValues(state, actionsToExpand, incQValues);
+
+            for (size_t index = 0; index < dfsQValues.size(); ++index) {
+                ASSERT_DOUBLE_EQ(dfsQValues[index], incQValues[index]);
+            }
+        }
+    }
+    DeterministicSearchEngine::stateValueCache.clear();
+}
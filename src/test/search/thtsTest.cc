@@ -0,0 +1,485 @@
+#include "../gtest/gtest.h"
+
+#include "../../search/parser.h"
+#include "../../search/thts.h"
+
+#include "../../search/utils/math_utils.h"
+#include "../../search/utils/random.h"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::unordered_set;
+using std::vector;
+
+// Tests of the memory management of THTS (recycling, reuse of pondered
+// subtrees, kept trees and transpositions) and of incremental backups. The
+// searches use a fixed number of trials, fixed seeds and no abstraction
+// updates, so they are deterministic except for pondering.
+class THTSTest : public testing::Test {
+protected:
+    void SetUp() override {
+        string problemFileName = "../test/testdomains/elevators_inst_mdp__1";
+        Parser parser(problemFileName);
+        map<string, int> stateVariableIndices;
+        vector<vector<string>> stateVariableValues;
+        parser.parseTask(stateVariableIndices, stateVariableValues);
+
+        // Other tests replace the random number generator with fakes
+        MathUtils::rnd = std::unique_ptr<Random<>>(new RandomMT());
+
+        // Discard the output of the search (see ProstPlanner)
+        coutBuffer = std::cout.rdbuf(nullptr);
+    }
+
+    void TearDown() override {
+        std::cout.rdbuf(coutBuffer);
+        clearCaches();
+    }
+
+    static void clearCaches() {
+        DeterministicSearchEngine::stateValueCache.clear();
+        ProbabilisticSearchEngine::stateValueCache.clear();
+    }
+
+    static THTS* createTHTS(string const& options) {
+        string desc = "[THTS -act [UCB1] -out [UMC] -init [Expand -h "
+                      "[RandomWalk]] -T TRIALS -uf 1000000000 " +
+                      options + "]";
+        THTS* thts = dynamic_cast<THTS*>(SearchEngine::fromString(desc));
+        assert(thts);
+        return thts;
+    }
+
+    // Samples the successor of state under the action with its own random
+    // number generator (such that the search is not influenced)
+    static State sampleSuccessor(State const& state, int actionIndex,
+                                 RandomMT& rnd) {
+        ActionState const& action = SearchEngine::actionStates[actionIndex];
+        State next(state.stepsToGo() - 1);
+        for (int i = 0; i < State::numberOfDeterministicStateFluents; ++i) {
+            SearchEngine::deterministicCPFs[i]->evaluate(
+                next.deterministicStateFluent(i), state, action);
+        }
+        for (int i = 0; i < State::numberOfProbabilisticStateFluents; ++i) {
+            DiscretePD pd;
+            SearchEngine::probabilisticCPFs[i]->evaluate(pd, state, action);
+            double randNum = rnd.genReal();
+            double probSum = 0.0;
+            double& value = next.probabilisticStateFluent(i);
+            value = pd.values.back();
+            for (size_t j = 0; j < pd.values.size(); ++j) {
+                probSum += pd.probabilities[j];
+                if (MathUtils::doubleIsSmaller(randNum, probSum)) {
+                    value = pd.values[j];
+                    break;
+                }
+            }
+        }
+        State::calcStateFluentHashKeys(next);
+        State::calcStateHashKey(next);
+        return next;
+    }
+
+    // Checks that the nodes that are reachable from the root node are exactly
+    // the first lastUsedNodePoolIndex nodes of the node pool, which must not
+    // contain duplicates
+    static void expectConsistentNodePool(THTS const* thts) {
+        if (!thts->currentRootNode) {
+            return;
+        }
+        ASSERT_LE(thts->lastUsedNodePoolIndex, thts->nodePool.size());
+        unordered_set<SearchNode const*> usedNodes;
+        for (int i = 0; i < thts->lastUsedNodePoolIndex; ++i) {
+            ASSERT_TRUE(thts->nodePool[i]);
+            ASSERT_TRUE(usedNodes.insert(thts->nodePool[i]).second)
+                << "node pool contains duplicate at " << i;
+        }
+
+        unordered_set<SearchNode const*> reachableNodes;
+        vector<SearchNode const*> open(1, thts->currentRootNode);
+        reachableNodes.insert(thts->currentRootNode);
+        while (!open.empty()) {
+            SearchNode const* node = open.back();
+            open.pop_back();
+            ASSERT_TRUE(usedNodes.find(node) != usedNodes.end())
+                << "reachable node is not in use";
+            for (SearchNode const* child : node->children) {
+                if (child && reachableNodes.insert(child).second) {
+                    open.push_back(child);
+                }
+            }
+        }
+        EXPECT_EQ(usedNodes.size(), reachableNodes.size());
+    }
+
+    // Checks that the weight sums of the incremental partial Bellman backups
+    // match the probabilities of the children
+    static void expectConsistentWeightSums(THTS const* thts) {
+        for (int i = 0; i < thts->lastUsedNodePoolIndex; ++i) {
+            SearchNode const* node = thts->nodePool[i];
+            if (!node->isChanceNode ||
+                !MathUtils::doubleIsGreater(node->childWeightSum, 0.0)) {
+                continue;
+            }
+            double probSum = 0.0;
+            for (SearchNode const* child : node->children) {
+                if (child) {
+                    probSum += child->prob;
+                }
+            }
+            EXPECT_NEAR(probSum, node->childWeightSum, 1e-9);
+        }
+    }
+
+    // Checks that the children of action nodes are the decision nodes of the
+    // joint outcomes, whose probabilities sum up to at most 1
+    static void expectJointOutcomes(THTS const* thts) {
+        for (int i = 0; i < thts->lastUsedNodePoolIndex; ++i) {
+            SearchNode const* node = thts->nodePool[i];
+            if (!node->isActionNode) {
+                continue;
+            }
+            double probSum = 0.0;
+            for (SearchNode const* child : node->children) {
+                if (child) {
+                    EXPECT_FALSE(child->isChanceNode);
+                    EXPECT_FALSE(child->isActionNode);
+                    probSum += child->prob;
+                }
+            }
+            EXPECT_LE(probSum, 1.0 + 1e-9);
+        }
+    }
+
+    // Computes the value of state with an expectimax search over the real
+    // transition distributions that enumerates all outcomes (without any
+    // memoization or pruning)
+    static double calcExpectimaxValue(THTS const* thts, State const& state) {
+        vector<int> actions = thts->getApplicableActions(state);
+        double value = -std::numeric_limits<double>::max();
+        for (size_t index = 0; index < actions.size(); ++index) {
+            // All applicable actions are considered in the last step, and
+            // otherwise the reasonable ones
+            if ((actions[index] < 0) ||
+                ((state.stepsToGo() > 1) && (actions[index] != index))) {
+                continue;
+            }
+            ActionState const& action = SearchEngine::actionStates[index];
+            double reward = 0.0;
+            SearchEngine::rewardCPF->evaluate(reward, state, action);
+            if (state.stepsToGo() > 1) {
+                reward += calcExpectedValue(thts, state, action);
+            }
+            value = std::max(value, reward);
+        }
+        return value;
+    }
+
+    static double calcExpectedValue(THTS const* thts, State const& state,
+                                    ActionState const& action) {
+        State next(state.stepsToGo() - 1);
+        for (int i = 0; i < State::numberOfDeterministicStateFluents; ++i) {
+            SearchEngine::deterministicCPFs[i]->evaluate(
+                next.deterministicStateFluent(i), state, action);
+        }
+        vector<DiscretePD> pds(State::numberOfProbabilisticStateFluents);
+        for (int i = 0; i < State::numberOfProbabilisticStateFluents; ++i) {
+            SearchEngine::probabilisticCPFs[i]->evaluate(pds[i], state, action);
+        }
+
+        // Enumerate the outcomes like a counter over the outcome indices
+        double expectedValue = 0.0;
+        vector<size_t> outcome(pds.size(), 0);
+        while (true) {
+            // The hash keys are added up, so they are computed on a copy
+            State outcomeState(next);
+            double prob = 1.0;
+            for (size_t i = 0; i < pds.size(); ++i) {
+                outcomeState.probabilisticStateFluent(i) =
+                    pds[i].values[outcome[i]];
+                prob *= pds[i].probabilities[outcome[i]];
+            }
+            State::calcStateFluentHashKeys(outcomeState);
+            State::calcStateHashKey(outcomeState);
+            expectedValue += prob * calcExpectimaxValue(thts, outcomeState);
+
+            size_t i = 0;
+            while ((i < pds.size()) && (++outcome[i] == pds[i].size())) {
+                outcome[i] = 0;
+                ++i;
+            }
+            if (i == pds.size()) {
+                return expectedValue;
+            }
+        }
+    }
+
+    static bool solveTail(THTS* thts, State const& state, double& value) {
+        return thts->solveTail(state, value);
+    }
+
+    // Plays the first steps of a round with the first best action, checks the
+    // node pool after each step and returns the Q-values of the root actions
+    // of all steps. If ponderingTime is positive, the submitted action is
+    // pondered after each step.
+    static vector<vector<double>> playSteps(THTS* thts, int numberOfSteps,
+                                            double ponderingTime,
+                                            RandomMT& rnd) {
+        vector<vector<double>> qValues;
+        State state(SearchEngine::initialState);
+        thts->initRound();
+        for (int step = 0; step < numberOfSteps; ++step) {
+            vector<int> bestActions;
+            thts->estimateBestActions(state, bestActions);
+            EXPECT_FALSE(bestActions.empty());
+            expectConsistentNodePool(thts);
+
+            qValues.push_back(vector<double>());
+            if (thts->currentRootNode) {
+                for (SearchNode const* child :
+                     thts->currentRootNode->children) {
+                    qValues.back().push_back(
+                        child ? child->getExpectedConcreteRewardEstimate()
+                              : -std::numeric_limits<double>::max());
+                }
+            }
+
+            if (MathUtils::doubleIsGreater(ponderingTime, 0.0)) {
+                thts->ponder(bestActions[0], ponderingTime);
+                expectConsistentNodePool(thts);
+            }
+            thts->finishStep();
+            state = sampleSuccessor(state, bestActions[0], rnd);
+        }
+        return qValues;
+    }
+
+    // The test bodies are subclasses of THTSTest, so they cannot access the
+    // private members of THTS themselves
+    static int getNumberOfRecyclings(THTS const* thts) {
+        return thts->numberOfRecyclings;
+    }
+
+    static int getNumberOfReusedNodes(THTS const* thts) {
+        return thts->numberOfReusedNodes;
+    }
+
+    static int getNumberOfRestoredNodes(THTS const* thts) {
+        return thts->numberOfRestoredNodes;
+    }
+
+    static int getNumberOfTranspositions(THTS const* thts) {
+        return thts->numberOfTranspositions;
+    }
+
+    static int getNumberOfUsedNodes(THTS const* thts) {
+        return thts->lastUsedNodePoolIndex;
+    }
+
+    static int getNumberOfMemoizedTransitions(THTS const* thts) {
+        return thts->numberOfMemoizedTransitions;
+    }
+
+    static void expectEqualQValues(vector<vector<double>> const& lhs,
+                                   vector<vector<double>> const& rhs) {
+        ASSERT_EQ(lhs.size(), rhs.size());
+        for (size_t step = 0; step < lhs.size(); ++step) {
+            ASSERT_EQ(lhs[step].size(), rhs[step].size());
+            for (size_t i = 0; i < lhs[step].size(); ++i) {
+                EXPECT_NEAR(lhs[step][i], rhs[step][i],
+                            1e-6 * (1.0 + std::abs(lhs[step][i])))
+                    << "in step " << step << " for action " << i;
+            }
+        }
+    }
+
+    std::streambuf* coutBuffer;
+};
+
+// Tests that the node pool contains exactly the reused subtree if the search
+// starts with the pondered subtree.
+TEST_F(THTSTest, reusedSubtreeIsCompact) {
+    for (int transpositions = 0; transpositions < 2; ++transpositions) {
+        clearCaches();
+        MathUtils::rnd->seed(1);
+        RandomMT rnd;
+        rnd.seed(1);
+        THTS* thts = createTHTS("-backup [PB] -r 300 -tt " +
+                                std::to_string(transpositions));
+        int reusedNodes = 0;
+        State state(SearchEngine::initialState);
+        thts->initRound();
+        for (int step = 0; step < 5; ++step) {
+            vector<int> bestActions;
+            thts->estimateBestActions(state, bestActions);
+            expectConsistentNodePool(thts);
+            reusedNodes += getNumberOfReusedNodes(thts);
+
+            thts->ponder(bestActions[0], 0.02);
+            expectConsistentNodePool(thts);
+            thts->finishStep();
+            state = sampleSuccessor(state, bestActions[0], rnd);
+        }
+        EXPECT_GT(reusedNodes, 0);
+        delete thts;
+    }
+}
+
+// Tests that trees that are kept for later rounds are moved out of the node
+// pool and back to its front when they are restored.
+TEST_F(THTSTest, restoredTreeIsCompact) {
+    for (int transpositions = 0; transpositions < 2; ++transpositions) {
+        clearCaches();
+        MathUtils::rnd->seed(1);
+        RandomMT rnd;
+        rnd.seed(1);
+        THTS* thts = createTHTS("-backup [PB] -r 300 -kt 1000000 -kts 2 -tt " +
+                                std::to_string(transpositions));
+        playSteps(thts, 3, 0.0, rnd);
+
+        // The tree of the initial state is restored in the next round
+        playSteps(thts, 1, 0.0, rnd);
+        EXPECT_GT(getNumberOfRestoredNodes(thts), 0);
+        delete thts;
+    }
+}
+
+// Tests that memoized transitions do not change the search, i.e., that the
+// Q-values are the same with and without memoization.
+TEST_F(THTSTest, memoizedTransitionsDoNotChangeQValues) {
+    vector<vector<double>> qValues[2];
+    for (int memoize = 0; memoize < 2; ++memoize) {
+        clearCaches();
+        MathUtils::rnd->seed(1);
+        RandomMT rnd;
+        rnd.seed(1);
+        THTS* thts = createTHTS("-backup [PB] -r 500 -mt " +
+                                std::to_string(memoize * 1000000));
+        qValues[memoize] = playSteps(thts, 5, 0.0, rnd);
+        EXPECT_EQ(memoize > 0, getNumberOfMemoizedTransitions(thts) > 0);
+        delete thts;
+    }
+    expectEqualQValues(qValues[0], qValues[1]);
+}
+
+// Tests that joint outcomes replace the layers of chance nodes.
+TEST_F(THTSTest, jointOutcomesAreDecisionNodes) {
+    MathUtils::rnd->seed(1);
+    RandomMT rnd;
+    rnd.seed(1);
+    THTS* thts = createTHTS("-backup [PB] -r 300 -jo 1");
+    thts->initRound();
+    State state(SearchEngine::initialState);
+    for (int step = 0; step < 5; ++step) {
+        vector<int> bestActions;
+        thts->estimateBestActions(state, bestActions);
+        EXPECT_FALSE(bestActions.empty());
+        expectConsistentNodePool(thts);
+        expectJointOutcomes(thts);
+        thts->finishStep();
+        state = sampleSuccessor(state, bestActions[0], rnd);
+    }
+    delete thts;
+}
+
+// Tests that recycling compacts the node pool such that it contains exactly
+// the remaining tree, also if the tree is a DAG because of transpositions.
+TEST_F(THTSTest, recycledTreeIsCompact) {
+    for (int transpositions = 0; transpositions < 2; ++transpositions) {
+        clearCaches();
+        MathUtils::rnd->seed(1);
+        RandomMT rnd;
+        rnd.seed(1);
+        THTS* thts = createTHTS("-backup [PB] -r 2000 -node-limit 1000 "
+                                "-recycle 0.5 -tt " +
+                                std::to_string(transpositions));
+        playSteps(thts, 5, 0.0, rnd);
+        EXPECT_GT(getNumberOfRecyclings(thts), 0);
+        delete thts;
+    }
+}
+
+// Tests that decision nodes of the same state share their subtree if
+// transpositions are used, such that fewer nodes are needed for the same
+// number of trials.
+TEST_F(THTSTest, transpositionsShareSubtrees) {
+    int usedNodes[2];
+    for (int transpositions = 0; transpositions < 2; ++transpositions) {
+        clearCaches();
+        MathUtils::rnd->seed(1);
+        THTS* thts = createTHTS("-backup [PB] -r 1000 -tt " +
+                                std::to_string(transpositions));
+        thts->initRound();
+        vector<int> bestActions;
+        thts->estimateBestActions(SearchEngine::initialState, bestActions);
+        expectConsistentNodePool(thts);
+        usedNodes[transpositions] = getNumberOfUsedNodes(thts);
+        EXPECT_EQ(transpositions > 0, getNumberOfTranspositions(thts) > 0);
+        delete thts;
+    }
+    EXPECT_LT(usedNodes[1], usedNodes[0]);
+}
+
+// Tests that the tail solver computes the same value as a full expectimax
+// search.
+TEST_F(THTSTest, tailSolverMatchesExpectimax) {
+    MathUtils::rnd->seed(1);
+    RandomMT rnd;
+    rnd.seed(1);
+    THTS* thts = createTHTS("-backup [PB] -r 100 -tst 100");
+    State state(SearchEngine::initialState);
+    for (int step = 0; step < 5; ++step) {
+        for (int stepsToGo = 1; stepsToGo <= 4; ++stepsToGo) {
+            State tail(state);
+            tail.stepsToGo() = stepsToGo;
+            double value = 0.0;
+            ASSERT_TRUE(solveTail(thts, tail, value));
+            double expectedValue = calcExpectimaxValue(thts, tail);
+            EXPECT_NEAR(expectedValue, value,
+                        1e-6 * (1.0 + std::abs(expectedValue)))
+                << "in step " << step << " with " << stepsToGo
+                << " remaining steps";
+        }
+        state = sampleSuccessor(state, MathUtils::rnd->genInt(
+                                           0, SearchEngine::numberOfActions - 1),
+                                rnd);
+    }
+    delete thts;
+}
+
+// Tests that incremental backups compute the same Q-values as backups that
+// consider all children, and that the weight sums of the incremental backups
+// are consistent after recycling.
+TEST_F(THTSTest, incrementalBackupsMatchFullBackups) {
+    vector<string> backups = {"MC", "PB"};
+    for (string const& backup : backups) {
+        for (int transpositions = 0; transpositions < 2; ++transpositions) {
+            vector<vector<double>> qValues[2];
+            for (int incremental = 0; incremental < 2; ++incremental) {
+                clearCaches();
+                MathUtils::rnd->seed(1);
+                RandomMT rnd;
+                rnd.seed(1);
+                THTS* thts = createTHTS(
+                    "-backup [" + backup + " -ib " +
+                    std::to_string(incremental) + "] -r 500 -node-limit 1500 "
+                    "-recycle 0.5 -tt " + std::to_string(transpositions));
+                qValues[incremental] = playSteps(thts, 5, 0.0, rnd);
+                if (incremental && (backup == "PB")) {
+                    expectConsistentWeightSums(thts);
+                }
+                delete thts;
+            }
+            expectEqualQValues(qValues[0], qValues[1]);
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#! /usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Measures the search throughput of the THTS shortcut configurations. Each
+# configuration is run with a fixed number of trials per step and fixed seeds
+# on all parser output files of the test domains (src/test/testdomains) and of
+# the given benchmark (testbed/benchmarks/<benchmark>/prost, which is created
+# by parse.py). The planner simulates the task itself (see the -r option of
+# prost), so no rddlsim server is needed. The results are written as CSV.
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+TESTBED_DIR = os.path.dirname(os.path.abspath(__file__))
+PROST = os.path.join(TESTBED_DIR, "..", "src", "search", "prost")
+TESTDOMAINS_DIR = os.path.join(TESTBED_DIR, "..", "src", "test", "testdomains")
+
+# The shortcuts of the UCT variants do not define an initializer
+configs = ["IPPC2011",
+           "IPPC2014",
+           "UCT -init [Single -h [RandomWalk]]",
+           "UCTStar -init [Expand -h [IDS]]",
+           "DP-UCT -init [Expand -h [IDS]]",
+           "MaxUCT -init [Expand -h [IDS]]"]
+
+# The abstraction is computed every -uf seconds, so a huge value disables it
+abstraction_options = [("yes", ""), ("no", "-uf 1000000000")]
+
+CSV_HEADER = ("instance,config,abstraction,trials,nodes,search_time,"
+              "abstraction_time,trials_per_second,nodes_per_second,"
+              "abstraction_share,peak_rss_kb")
+
+
+def is_parser_output(file_name):
+    return "_inst_" in file_name and "." not in file_name
+
+
+def collect_instances(benchmark):
+    directories = [TESTDOMAINS_DIR]
+    if benchmark:
+        directories.append(os.path.join(TESTBED_DIR, "benchmarks", benchmark,
+                                        "prost"))
+    instances = []
+    for directory in directories:
+        if not os.path.isdir(directory):
+            print("Skipping %s (run parse.py on the benchmark first)" %
+                  directory, file=sys.stderr)
+            continue
+        for file_name in sorted(os.listdir(directory)):
+            if is_parser_output(file_name):
+                instances.append(os.path.join(directory, file_name))
+    return instances
+
+
+def sum_of(pattern, log, description):
+    # A missing field means that the output format of the planner changed, so
+    # summing up nothing would silently report wrong numbers
+    values = re.findall(pattern, log)
+    if not values:
+        print("Cannot find the %s in the output of the planner:\n%s" %
+              (description, log[-2000:]), file=sys.stderr)
+        sys.exit(1)
+    return sum(float(value) for value in values)
+
+
+def run(instance, config, option, trials, seed):
+    planner = ("[PROST -s %d -se [%s %s -T TRIALS -r %d]]" %
+               (seed, config, option, trials))
+    cmd = [PROST, instance, "-r", "1", "--simulator-seed", str(seed), planner]
+    process = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                               stderr=subprocess.STDOUT)
+    log = process.stdout.read().decode("utf-8", "replace")
+    process.stdout.close()
+
+    # Reap the child ourselves to get its resource usage (ru_maxrss is in KB)
+    status, rusage = os.wait4(process.pid, 0)[1:]
+    process.returncode = 0
+    if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+        print("%s failed on %s:\n%s" % (config, instance, log[-2000:]),
+              file=sys.stderr)
+        return None
+
+    trials = sum_of(r"Performed trials: ([0-9]+)", log, "trials")
+    nodes = sum_of(r"Created SearchNodes: ([0-9]+)", log, "search nodes")
+    search_time = sum_of(r"Search time: ([0-9.e+-]+)s?", log, "search time")
+    abstraction_time = sum_of(r"generating abstraction: ([0-9.e+-]+)s?", log,
+                              "abstraction time")
+    return trials, nodes, search_time, abstraction_time, rusage.ru_maxrss
+
+
+def ratio(numerator, denominator):
+    if denominator <= 0.0:
+        return 0.0
+    return numerator / denominator
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Trials per second benchmark of the THTS configurations")
+    parser.add_argument("--benchmark", default="ippc2014",
+                        help="benchmark in testbed/benchmarks whose parsed "
+                        "instances are used in addition to the test domains "
+                        "(empty string for the test domains only)")
+    parser.add_argument("--config", action="append", dest="configs",
+                        help="search engine configuration without brackets "
+                        "(e.g. \"IPPC2014 -crl 0\"), may be given several times "
+                        "(default: all shortcut configurations)")
+    parser.add_argument("--trials", type=int, default=1000,
+                        help="number of trials per step")
+    parser.add_argument("--seed", type=int, default=1,
+                        help="seed of planner and simulator")
+    parser.add_argument("--output", help="CSV file (default: stdout)")
+    args = parser.parse_args()
+
+    if not os.path.isfile(PROST):
+        print("Cannot find %s, please build the planner first" % PROST,
+              file=sys.stderr)
+        sys.exit(1)
+
+    benchmark_configs = args.configs or configs
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    print(CSV_HEADER, file=out)
+    for instance in collect_instances(args.benchmark):
+        for config in benchmark_configs:
+            for abstraction, option in abstraction_options:
+                result = run(instance, config, option, args.trials, args.seed)
+                if not result:
+                    continue
+                trials, nodes, search_time, abstraction_time, rss = result
+                total_time = search_time + abstraction_time
+                print("%s,\"%s\",%s,%d,%d,%.4f,%.4f,%.2f,%.2f,%.4f,%d" %
+                      (os.path.basename(instance), config, abstraction,
+                       trials, nodes, search_time, abstraction_time,
+                       ratio(trials, total_time), ratio(nodes, total_time),
+                       ratio(abstraction_time, total_time), rss), file=out)
+                out.flush()
+    if args.output:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()